@@ -0,0 +1,263 @@
+#include "Batch.h"
+
+// Kernels are written once over a lane type: uint64_t for scalar, GCC vector extensions for SIMD
+// Each instruction set has an entry point compiled for it (target attribute), which the generic kernels are force-inlined into
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define BATCH_SIMD 1
+#else
+#define BATCH_SIMD 0
+#endif
+
+#if BATCH_SIMD
+// Vectors never cross a call (everything is inlined into the entry points), so the ABI warnings don't apply
+#pragma GCC diagnostic ignored "-Wpsabi"
+#define BATCH_INLINE __attribute__((always_inline)) inline
+typedef uint64_t Lanes4 __attribute__((vector_size(32)));
+typedef uint64_t Lanes8 __attribute__((vector_size(64)));
+#else
+#define BATCH_INLINE inline
+#endif
+
+constexpr uint64_t BOARD_MASK = BoardMask::GetBoardMask();
+constexpr uint64_t BOTTOM_MASK = BoardMask::GetBottomMask();
+
+#if BATCH_SIMD
+// Results of EvalAndCropValidMoves() as little-endian { val, depth } pairs
+static_assert(sizeof(Value) == 2 && offsetof(Value, depth) == 1, "Batched values assume a 2-byte Value");
+constexpr uint64_t PACKED_LOSS_IN_2 = 0x02FF;
+constexpr uint64_t PACKED_DRAW_IN_2 = 0x0200;
+constexpr uint64_t PACKED_INVALID = 0x0080;
+#endif
+
+// All ones where the lane is non-zero
+template <typename T>
+BATCH_INLINE static T NonZero(const T& lanes) {
+	if constexpr (std::is_same_v<T, uint64_t>) {
+		return -(uint64_t)(lanes != 0);
+	} else {
+		return (T)(lanes != 0);
+	}
+}
+
+// Same as Util::HasMinBitsSet<2>()
+template <typename T>
+BATCH_INLINE static T HasTwoBits(const T& lanes) {
+	return NonZero(lanes & (lanes - 1));
+}
+
+// Three in a row through each cell along a direction, in both orientations (with the cell at either end or in the middle)
+template <typename T>
+BATCH_INLINE static T CheckDirLanes(const T& mask, int shift) {
+	T pairUp = (mask << shift) & (mask << (shift * 2));
+	T pairDown = (mask >> shift) & (mask >> (shift * 2));
+	return (pairUp & ((mask >> shift) | (mask << (shift * 3)))) | (pairDown & ((mask << shift) | (mask >> (shift * 3))));
+}
+
+// Same as BoardMask::MakeWinMask() for connect 4
+template <typename T>
+BATCH_INLINE static T MakeWinMaskLanes(const T& mask) {
+	// Vertical, only upward since pieces can't float
+	T winMask = (mask << 1) & (mask << 2) & (mask << 3);
+
+	// Horizontal, then both diagonals
+	winMask |= CheckDirLanes(mask, 8);
+	winMask |= CheckDirLanes(mask, 7);
+	winMask |= CheckDirLanes(mask, 9);
+
+	return winMask & BOARD_MASK;
+}
+
+template <typename T>
+BATCH_INLINE static T GetValidMovesLanes(const T& combined) {
+	return ((combined << 1) | BOTTOM_MASK) & BOARD_MASK & ~combined;
+}
+
+template <typename T>
+BATCH_INLINE static T Load(const uint64_t* ptr) {
+	T lanes;
+	memcpy(&lanes, ptr, sizeof(T));
+	return lanes;
+}
+
+template <typename T>
+BATCH_INLINE static void Store(uint64_t* ptr, const T& lanes) {
+	memcpy(ptr, &lanes, sizeof(T));
+}
+
+template <typename T>
+constexpr size_t NUM_LANES = sizeof(T) / sizeof(uint64_t);
+
+// Each step processes the boards of one lane type from index i on
+template <typename T>
+BATCH_INLINE static void MakeWinMasksStep(const uint64_t* masks, uint64_t* outWinMasks, size_t i) {
+	if constexpr (CONNECT_WIN_AMOUNT == 4) {
+		Store<T>(outWinMasks + i, MakeWinMaskLanes(Load<T>(masks + i)));
+	} else {
+		for (size_t j = 0; j < NUM_LANES<T>; j++)
+			outWinMasks[i + j] = BoardMask::MakeWinMask(masks[i + j]);
+	}
+}
+
+template <typename T>
+BATCH_INLINE static void GetValidMoveMasksStep(const uint64_t* combinedMasks, uint64_t* outMoves, size_t i) {
+	Store<T>(outMoves + i, GetValidMovesLanes(Load<T>(combinedMasks + i)));
+}
+
+template <typename T>
+BATCH_INLINE static void MakeChildWinMasksStep(uint64_t selfMask, uint64_t oppMask, const uint64_t* moves, uint64_t* outWinMasks, size_t i) {
+	if constexpr (CONNECT_WIN_AMOUNT == 4) {
+		Store<T>(outWinMasks + i, MakeWinMaskLanes(Load<T>(moves + i) | selfMask) & ~oppMask);
+	} else {
+		for (size_t j = 0; j < NUM_LANES<T>; j++)
+			outWinMasks[i + j] = BoardMask::MakeWinMask(moves[i + j] | selfMask) & ~oppMask;
+	}
+}
+
+template <typename T>
+BATCH_INLINE static void EvalAndCropValidMovesStep(
+	const uint64_t* selfMasks, const uint64_t* oppMasks, const uint64_t* oppWinMasks,
+	uint64_t* outMoves, Value* outValues, size_t i) {
+
+	T combined = Load<T>(selfMasks + i) | Load<T>(oppMasks + i);
+	T oppWin = Load<T>(oppWinMasks + i);
+	T validMoves = GetValidMovesLanes(combined);
+
+	// Forced to block the opponent's win next turn, lost if there are two of them
+	T oppWinNext = oppWin & validMoves;
+	T forced = NonZero(oppWinNext);
+	T lost = HasTwoBits(oppWinNext);
+	validMoves = (oppWinNext & forced) | (validMoves & ~forced);
+
+	// Never play below a winning cell of the opponent
+	validMoves &= ~(oppWin >> 1);
+	lost |= ~NonZero(validMoves);
+
+	// Draw with at most two cells left
+	T unplayed = ~combined & BOARD_MASK;
+	T drawn = ~HasTwoBits(unplayed & (unplayed - 1)) & ~lost;
+
+	Store<T>(outMoves + i, validMoves);
+
+	if constexpr (std::is_same_v<T, uint64_t>) {
+		outValues[i] = lost ? Value(-1, 2) : (drawn ? Value(0, 2) : VALUE_INVALID);
+	} else {
+#if BATCH_SIMD
+		// Values are built in the lanes (val in the low byte, depth in the high byte), then narrowed to 16 bits
+		T packedValues = (lost & PACKED_LOSS_IN_2) | (drawn & PACKED_DRAW_IN_2) | (~(lost | drawn) & PACKED_INVALID);
+		typedef uint16_t PackedLanes __attribute__((vector_size(NUM_LANES<T> * sizeof(uint16_t))));
+		PackedLanes narrowed = __builtin_convertvector(packedValues, PackedLanes);
+		memcpy((void*)(outValues + i), &narrowed, sizeof(narrowed));
+#endif
+	}
+}
+
+// Whole vectors, then the rest one board at a time
+#define LANES_LOOP(name, T, args) { \
+	size_t i = 0; \
+	for (; i + NUM_LANES<T> <= count; i += NUM_LANES<T>) \
+		name##Step<T> args; \
+	for (; i < count; i++) \
+		name##Step<uint64_t> args; \
+}
+
+// Entry points of each instruction set, indexed by Isa
+#if BATCH_SIMD
+#define DEFINE_ENTRY_POINTS(name, params, args) \
+	static void name##Scalar params LANES_LOOP(name, uint64_t, args) \
+	__attribute__((target("avx2"))) static void name##Avx2 params LANES_LOOP(name, Lanes4, args) \
+	__attribute__((target("avx512f"))) static void name##Avx512 params LANES_LOOP(name, Lanes8, args) \
+	static void (*const name##Fns[ISA_COUNT]) params = { name##Scalar, name##Avx2, name##Avx512 };
+#else
+#define DEFINE_ENTRY_POINTS(name, params, args) \
+	static void name##Scalar params LANES_LOOP(name, uint64_t, args) \
+	static void (*const name##Fns[ISA_COUNT]) params = { name##Scalar, name##Scalar, name##Scalar };
+#endif
+
+using namespace Batch;
+
+DEFINE_ENTRY_POINTS(
+	MakeWinMasks,
+	(const uint64_t* masks, uint64_t* outWinMasks, size_t count),
+	(masks, outWinMasks, i)
+)
+
+DEFINE_ENTRY_POINTS(
+	GetValidMoveMasks,
+	(const uint64_t* combinedMasks, uint64_t* outMoves, size_t count),
+	(combinedMasks, outMoves, i)
+)
+
+DEFINE_ENTRY_POINTS(
+	EvalAndCropValidMoves,
+	(const uint64_t* selfMasks, const uint64_t* oppMasks, const uint64_t* oppWinMasks, uint64_t* outMoves, Value* outValues, size_t count),
+	(selfMasks, oppMasks, oppWinMasks, outMoves, outValues, i)
+)
+
+// A node's moves fit in one AVX-512 vector or two AVX2 vectors, the scalar version only does the actual moves
+#define NODE_LANES_LOOP(T) { \
+	size_t count = (NUM_LANES<T> == 1) ? numMoves : NODE_LANES; \
+	for (size_t i = 0; i < count; i += NUM_LANES<T>) \
+		MakeChildWinMasksStep<T>(selfMask, oppMask, moves, outWinMasks, i); \
+}
+
+#define CHILD_WIN_MASKS_PARAMS (uint64_t selfMask, uint64_t oppMask, const uint64_t* moves, int numMoves, uint64_t* outWinMasks)
+static void MakeChildWinMasksScalar CHILD_WIN_MASKS_PARAMS NODE_LANES_LOOP(uint64_t)
+#if BATCH_SIMD
+__attribute__((target("avx2"))) static void MakeChildWinMasksAvx2 CHILD_WIN_MASKS_PARAMS NODE_LANES_LOOP(Lanes4)
+__attribute__((target("avx512f"))) static void MakeChildWinMasksAvx512 CHILD_WIN_MASKS_PARAMS NODE_LANES_LOOP(Lanes8)
+static void (*const MakeChildWinMasksFns[ISA_COUNT]) CHILD_WIN_MASKS_PARAMS = { MakeChildWinMasksScalar, MakeChildWinMasksAvx2, MakeChildWinMasksAvx512 };
+#else
+static void (*const MakeChildWinMasksFns[ISA_COUNT]) CHILD_WIN_MASKS_PARAMS = { MakeChildWinMasksScalar, MakeChildWinMasksScalar, MakeChildWinMasksScalar };
+#endif
+
+bool Batch::IsSupported(Isa isa) {
+	switch (isa) {
+	case ISA_SCALAR:
+		return true;
+#if BATCH_SIMD
+	case ISA_AVX2:
+		return __builtin_cpu_supports("avx2");
+	case ISA_AVX512:
+		return __builtin_cpu_supports("avx512f");
+#endif
+	default:
+		return false;
+	}
+}
+
+Isa Batch::GetBestIsa() {
+	static const Isa bestIsa = [] {
+		for (int isa = ISA_COUNT - 1; isa > ISA_SCALAR; isa--)
+			if (IsSupported((Isa)isa))
+				return (Isa)isa;
+		return ISA_SCALAR;
+	}();
+	return bestIsa;
+}
+
+void Batch::MakeWinMasks(const uint64_t* masks, uint64_t* outWinMasks, size_t count, Isa isa) {
+	ASSERT(IsSupported(isa), "Unsupported instruction set");
+	MakeWinMasksFns[isa](masks, outWinMasks, count);
+}
+
+void Batch::GetValidMoveMasks(const uint64_t* combinedMasks, uint64_t* outMoves, size_t count, Isa isa) {
+	ASSERT(IsSupported(isa), "Unsupported instruction set");
+	GetValidMoveMasksFns[isa](combinedMasks, outMoves, count);
+}
+
+void Batch::MakeChildWinMasks(
+	BoardMask selfMask, BoardMask oppMask, const BoardMask* moves, int numMoves,
+	BoardMask* outWinMasks, Isa isa) {
+
+	static_assert(sizeof(BoardMask) == sizeof(uint64_t));
+	ASSERT(IsSupported(isa), "Unsupported instruction set");
+	MakeChildWinMasksFns[isa](selfMask, oppMask, (const uint64_t*)moves, numMoves, (uint64_t*)outWinMasks);
+}
+
+void Batch::EvalAndCropValidMoves(
+	const uint64_t* selfMasks, const uint64_t* oppMasks, const uint64_t* oppWinMasks,
+	uint64_t* outMoves, Value* outValues, size_t count, Isa isa) {
+
+	ASSERT(IsSupported(isa), "Unsupported instruction set");
+	EvalAndCropValidMovesFns[isa](selfMasks, oppMasks, oppWinMasks, outMoves, outValues, count);
+}
\ No newline at end of file
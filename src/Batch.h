@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Eval.h"
+
+// Bitboard kernels over many independent boards per call, for bulk work (enumeration, tablebase and book builds, benchmarks)
+// Boards are given as arrays of masks (structure of arrays), processed in 64-bit SIMD lanes: 4 per AVX2 vector, 8 per AVX-512 vector
+// The instruction set is picked at runtime, every one of them gives the same results as the scalar BoardState/Eval functions
+namespace Batch {
+	enum Isa {
+		ISA_SCALAR,
+		ISA_AVX2,
+		ISA_AVX512,
+
+		ISA_COUNT
+	};
+
+	constexpr const char* ISA_NAMES[ISA_COUNT] = { "scalar", "avx2", "avx512" };
+
+	// Best instruction set supported by this cpu (and build)
+	Isa GetBestIsa();
+	bool IsSupported(Isa isa);
+
+	// BoardMask::MakeWinMask() of each mask
+	void MakeWinMasks(const uint64_t* masks, uint64_t* outWinMasks, size_t count, Isa isa = GetBestIsa());
+
+	// BoardState::GetValidMoveMask() of each combined mask
+	void GetValidMoveMasks(const uint64_t* combinedMasks, uint64_t* outMoves, size_t count, Isa isa = GetBestIsa());
+
+	// Lanes of the per-node kernel, its move and win mask arrays need at least this many entries
+	constexpr int NODE_LANES = 8;
+	static_assert(BOARD_SIZE_X <= NODE_LANES, "A node's moves must fit in its lanes");
+
+	// The turn player's win mask after each of a node's moves, the same as FillMove() makes them
+	// Entries past numMoves are read and written, but meaningless
+	void MakeChildWinMasks(
+		BoardMask selfMask, BoardMask oppMask, const BoardMask* moves, int numMoves,
+		BoardMask* outWinMasks, Isa isa = GetBestIsa()
+	);
+
+	// Eval::EvalAndCropValidMoves() of each board, starting from all of its valid moves
+	// Masks are from the perspective of the side to move, outMoves is only meaningful where the value is VALUE_INVALID
+	void EvalAndCropValidMoves(
+		const uint64_t* selfMasks, const uint64_t* oppMasks, const uint64_t* oppWinMasks,
+		uint64_t* outMoves, Value* outValues, size_t count, Isa isa = GetBestIsa()
+	);
+}
\ No newline at end of file
@@ -1,18 +1,17 @@
 #include "BoardState.h"
 
-constexpr int MAX_RECONSTRUCTION_NODES = 10'000;
-
 // Determines the moves used to recreate a board
-bool ReconstructMovesRecursive(const BoardState& targetBoard, const BoardState& curBoard, std::vector<int>& moves, uint64_t& nodeCount) {
+// Positions that can't lead to the target are remembered by their combined mask,
+// so at most (BOARD_SIZE_Y + 1) ^ BOARD_SIZE_X positions are ever expanded
+bool ReconstructMovesRecursive(const BoardState& targetBoard, const BoardState& curBoard, std::vector<int>& moves, std::unordered_set<uint64_t>& deadEnds) {
 	if (curBoard.GetCombinedMask() == targetBoard.GetCombinedMask())
 		return true;
+
+	if (deadEnds.count(curBoard.GetCombinedMask()))
+		return false;
 	
 	auto curMoves = curBoard.GetValidMoveMask() & targetBoard.teams[curBoard.turnSwitch];
 	auto itr = MoveIterator(curMoves);
-	nodeCount++;
-
-	if (nodeCount > MAX_RECONSTRUCTION_NODES)
-		return false;
 
 	while (auto move = itr.GetNext()) {
 		BoardState nextBoard = curBoard;
@@ -20,19 +19,20 @@ bool ReconstructMovesRecursive(const BoardState& targetBoard, const BoardState&
 		int slotNum = Util::BitMaskToIndex(move) / 8 + 1;
 		moves.push_back(slotNum);
 
-		if (ReconstructMovesRecursive(targetBoard, nextBoard, moves, nodeCount))
+		if (ReconstructMovesRecursive(targetBoard, nextBoard, moves, deadEnds))
 			return true;
 		
 		moves.pop_back();
 	}
 
+	deadEnds.insert(curBoard.GetCombinedMask());
 	return false;
 }
 
 std::vector<int> ReconstructMoves(const BoardState& board) {
 	std::vector<int> moves = {};
-	uint64_t nodeCount = 0;
-	if (ReconstructMovesRecursive(board, BoardState(), moves, nodeCount)) {
+	std::unordered_set<uint64_t> deadEnds = {};
+	if (ReconstructMovesRecursive(board, BoardState(), moves, deadEnds)) {
 		return moves;
 	} else {
 		return {};
@@ -45,8 +45,10 @@ std::ostream& operator<<(std::ostream& stream, const BoardState& boardState) {
 	stream << "{" << std::endl;
 	stream << "\tTurn: " << TEAM_CHARS[(int)boardState.turnSwitch] << ", movecount: " << (int)boardState.moveCount << std::endl;
 
-	auto possibleMoves = ReconstructMoves(boardState);
-	if (!possibleMoves.empty()) {
+	if (boardState.firstHistoryPly == 0) {
+		// The history goes back to the empty board
+		stream << "\tMoves: " << boardState.GetMoveString() << std::endl;
+	} else if (auto possibleMoves = ReconstructMoves(boardState); !possibleMoves.empty()) {
 		stream << "\tPossible moves: ";
 		for (int slotNum : possibleMoves)
 			stream << slotNum;
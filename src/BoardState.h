@@ -172,6 +172,11 @@ struct BoardState {
 	BoardMask teams[2];
 	BoardMask winMasks[2];
 
+	// Column of the move played at each ply
+	// Only plies from firstHistoryPly on are known, boards built from masks start their history at their move count
+	uint8_t moveHistory[BOARD_CELL_COUNT] = {};
+	int8_t firstHistoryPly = 0;
+
 	constexpr BoardState(BoardMask team0 = 0, BoardMask team1 = 0) {
 		teams[0] = team0;
 		teams[1] = team1;
@@ -180,6 +185,7 @@ struct BoardState {
 
 		moveCount = Util::BitCount64(GetCombinedMask());
 		turnSwitch = moveCount % 2;
+		firstHistoryPly = moveCount;
 	}
 
 	constexpr BoardMask GetCombinedMask() const {
@@ -215,12 +221,57 @@ struct BoardState {
 	}
 
 	void FillMove(BoardMask moveMask) {
+		FillMove(moveMask, BoardMask::MakeWinMask(teams[turnSwitch] | moveMask) & ~teams[!turnSwitch]);
+	}
+
+	// Same as FillMove(), with the turn player's win mask after the move already made
+	void FillMove(BoardMask moveMask, BoardMask nextWinMask) {
+		moveHistory[moveCount] = Util::BitMaskToIndex(moveMask) / 8;
 		teams[turnSwitch] |= moveMask;
-		winMasks[turnSwitch] = teams[turnSwitch].MakeWinMask() & ~teams[!turnSwitch];
+		winMasks[turnSwitch] = nextWinMask;
 		turnSwitch = !turnSwitch;
 		moveCount++;
 	}
 
+	bool CanUndoMove() const {
+		return moveCount > firstHistoryPly;
+	}
+
+	// Returns the board to exactly the state before the last FillMove()
+	void UndoMove() {
+		UndoMove(0);
+
+		// Our win mask was last made before the opponent's last move, so that move isn't cropped out of it
+		BoardMask oppMask = teams[!turnSwitch];
+		if (moveCount > firstHistoryPly)
+			oppMask &= ~GetColumnTop(moveHistory[moveCount - 1]);
+
+		winMasks[turnSwitch] = teams[turnSwitch].MakeWinMask() & ~oppMask;
+	}
+
+	// Same as UndoMove(), but cheaper if the mover's win mask from before the move was kept
+	void UndoMove(BoardMask prevWinMask) {
+		assert(CanUndoMove());
+		moveCount--;
+		turnSwitch = !turnSwitch;
+		teams[turnSwitch] &= ~GetColumnTop(moveHistory[moveCount]);
+		winMasks[turnSwitch] = prevWinMask;
+	}
+
+	// Highest filled cell of a column (0 if it's empty)
+	constexpr BoardMask GetColumnTop(int x) const {
+		BoardMask column = GetCombinedMask() & BoardMask::GetColumnMask(x);
+		return column & ~(column >> 1);
+	}
+
+	// Moves as column digits starting at 1 (playable with PlayMoveString), from firstHistoryPly on
+	std::string GetMoveString() const {
+		std::string result = {};
+		for (int i = firstHistoryPly; i < moveCount; i++)
+			result += '1' + moveHistory[i];
+		return result;
+	}
+
 	void DoMove(int x) {
 		uint8_t y = GetNextY(x);
 		BoardMask moveMask = 0;
@@ -245,6 +296,55 @@ struct BoardState {
 		}
 	}
 
+	// Unique key of the position, each column holds the turn player's pieces plus a bit above the top piece
+	// Ref: https://github.com/PascalPons/connect4/blob/master/Position.hpp#L157
+	constexpr uint64_t GetKey() const {
+		return teams[turnSwitch] + GetCombinedMask() + BoardMask::GetBottomMask();
+	}
+
+	constexpr uint64_t GetMirroredKey() const {
+		return teams[turnSwitch].FlipX() + GetCombinedMask().FlipX() + BoardMask::GetBottomMask();
+	}
+
+	// Same for a position and its mirror image
+	constexpr uint64_t GetCanonicalKey() const {
+		return MIN(GetKey(), GetMirroredKey());
+	}
+
+	// Turn player's pieces and all pieces of a key, without building the board
+	// Returns false if the key isn't a valid position key
+	static bool DecodeKey(uint64_t key, BoardMask& outSelfMask, BoardMask& outCombinedMask) {
+		outSelfMask = 0;
+		outCombinedMask = 0;
+		for (int x = 0; x < BOARD_SIZE_X; x++) {
+			uint8_t column = (uint8_t)(key >> (x * 8));
+			if (column == 0)
+				return false;
+
+			int height = std::bit_width(column) - 1;
+			if (height > BOARD_SIZE_Y)
+				return false;
+
+			uint8_t heightBit = 1 << height;
+			outSelfMask.GetColumn(x) = column - heightBit;
+			outCombinedMask.GetColumn(x) = heightBit - 1;
+		}
+
+		return !(key & ~(BoardMask::GetBoardMask() | (BoardMask::GetBoardMask() << 1) | BoardMask::GetBottomMask()));
+	}
+
+	// Returns false if the key isn't a valid position key
+	static bool FromKey(uint64_t key, BoardState& outBoard) {
+		BoardMask selfMask, combinedMask;
+		if (!DecodeKey(key, selfMask, combinedMask))
+			return false;
+
+		bool turnSwitch = Util::BitCount64(combinedMask) % 2;
+		BoardMask oppMask = combinedMask & ~selfMask;
+		outBoard = turnSwitch ? BoardState(oppMask, selfMask) : BoardState(selfMask, oppMask);
+		return true;
+	}
+
 	constexpr bool operator==(const BoardState& other) {
 		return 
 			(teams[0] == other.teams[0] && teams[1] == other.teams[1]) && 
@@ -258,4 +358,7 @@ struct BoardState {
 	}
 
 	friend std::ostream& operator<<(std::ostream& stream, const BoardState& boardState);
-};
\ No newline at end of file
+};
+
+// Searches for moves (column numbers starting at 1) that recreate the board, empty if there are none
+std::vector<int> ReconstructMoves(const BoardState& board);
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include "Book.h"
+#include "DataStream.h"
+#include "Enumerate.h"
+#include "Search.h"
+
+constexpr double PROGRESS_LOG_INTERVAL = 10;
+
+template <typename T>
+static void RunThreads(int numThreads, T&& fnWork) {
+	std::vector<std::thread> threads;
+	for (int i = 1; i < numThreads; i++)
+		threads.push_back(std::thread(fnWork, i));
+	fnWork(0);
+	for (auto& thread : threads)
+		thread.join();
+}
+
+bool Book::Build(const std::filesystem::path& path, const BuildConfig& config) {
+	RASSERT(config.maxPly >= 0 && config.maxPly < BOARD_CELL_COUNT, "Bad book ply: " << config.maxPly);
+	RASSERT(config.numThreads >= 1, "Bad thread count: " << config.numThreads);
+
+	// (Move by move, as PlayMoveString plays on past a win)
+	BoardState root = {};
+	for (char c : config.rootMoves) {
+		root.PlayMoveString(std::string(1, c));
+		if (Eval::IsWonAfterMove(root)) {
+			WARN("The game is already over at the book root \"" << config.rootMoves << "\"");
+			return false;
+		}
+	}
+	RASSERT(root.moveCount <= config.maxPly, "Book root is past the book's ply");
+
+	LOG("Building book of positions up to ply " << config.maxPly << " below \"" << config.rootMoves << "\"...");
+	Timer timer = {};
+
+	std::vector<std::vector<uint64_t>> plyKeys = std::vector<std::vector<uint64_t>>(config.maxPly + 1);
+	plyKeys[root.moveCount] = { root.GetCanonicalKey() };
+	for (int ply = root.moveCount + 1; ply <= config.maxPly; ply++)
+		plyKeys[ply] = Enumerate::ExpandKeys(plyKeys[ply - 1], config.numThreads);
+
+	std::vector<uint64_t> keys;
+	for (auto& levelKeys : plyKeys)
+		keys.insert(keys.end(), levelKeys.begin(), levelKeys.end());
+	double enumerateTime = timer.Elapsed();
+
+	FileHeader header = {};
+	memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+	header.version = FILE_VERSION;
+	header.boardSizeX = BOARD_SIZE_X;
+	header.boardSizeY = BOARD_SIZE_Y;
+	header.connectWinAmount = CONNECT_WIN_AMOUNT;
+	header.rootPly = root.moveCount;
+	header.maxPly = config.maxPly;
+	header.rootKey = root.GetCanonicalKey();
+
+	// Header, perfect hash, then the values
+	std::vector<uint64_t> hashData = PerfectHash::Build(keys, sizeof(FileHeader), header.hash, config.numThreads);
+	header.valuesOffset = sizeof(FileHeader) + hashData.size() * sizeof(uint64_t);
+
+	std::vector<uint64_t> data = std::vector<uint64_t>((header.valuesOffset + (keys.size() + 3) / 4 + 7) / sizeof(uint64_t));
+	memcpy(data.data(), &header, sizeof(header));
+	std::copy(hashData.begin(), hashData.end(), data.begin() + sizeof(FileHeader) / sizeof(uint64_t));
+	const uint8_t* dataBytes = (const uint8_t*)data.data();
+	double hashTime = timer.Elapsed() - enumerateTime;
+
+	// Search the last ply, then value the plies before it from the plies after them
+	std::vector<uint8_t> values = std::vector<uint8_t>(keys.size(), PACKED_DRAW);
+	for (int ply = config.maxPly; ply >= (int)root.moveCount; ply--) {
+		const std::vector<uint64_t>& levelKeys = plyKeys[ply];
+		bool searchPly = (ply == config.maxPly);
+
+		std::atomic<uint64_t> nextIndex = 0, numSolved = 0;
+		RunThreads(config.numThreads, [&](int threadIndex) {
+			std::unique_ptr<TranspositionTable> table = searchPly ? std::make_unique<TranspositionTable>(config.tableSizeLog2) : NULL;
+			double lastLogTime = timer.Elapsed();
+
+			for (uint64_t i = nextIndex++; i < levelKeys.size(); i = nextIndex++) {
+				BoardState board;
+				BoardState::FromKey(levelKeys[i], board);
+
+				uint8_t value;
+				if (searchPly) {
+					Value eval = Search::Search(table.get(), board, false).eval;
+					value = (eval.val > 0) ? PACKED_WIN : ((eval.val < 0) ? PACKED_LOSS : PACKED_DRAW);
+				} else if (board.GetValidMoveMask() & board.winMasks[board.turnSwitch]) {
+					value = PACKED_WIN;
+				} else {
+					value = PACKED_LOSS;
+					auto moveItr = MoveIterator(board.GetValidMoveMask());
+					while (BoardMask move = moveItr.GetNext()) {
+						BoardState nextBoard = board;
+						nextBoard.FillMove(move);
+
+						// The child's result is the opponent's
+						uint8_t childValue = values[PerfectHash::GetIndex(header.hash, dataBytes, nextBoard.GetCanonicalKey())];
+						value = MAX(value, (uint8_t)(PACKED_WIN - childValue));
+						if (value == PACKED_WIN)
+							break;
+					}
+				}
+				values[PerfectHash::GetIndex(header.hash, dataBytes, levelKeys[i])] = value;
+				numSolved++;
+
+				if (searchPly && threadIndex == 0 && timer.Elapsed() - lastLogTime >= PROGRESS_LOG_INTERVAL) {
+					lastLogTime = timer.Elapsed();
+					LOG(" > Searched " << numSolved << "/" << levelKeys.size() << " positions of ply " << ply);
+				}
+			}
+		});
+	}
+	double solveTime = timer.Elapsed() - enumerateTime - hashTime;
+
+	uint8_t* packedValues = (uint8_t*)data.data() + header.valuesOffset;
+	for (size_t i = 0; i < values.size(); i++)
+		packedValues[i / 4] |= values[i] << ((i % 4) * 2);
+
+	uint64_t size = data.size() * sizeof(uint64_t);
+	{
+		DataStream stream = DataStream(path);
+		stream.WriteRaw(data.data(), size);
+		if (!stream.stream) {
+			WARN("Failed to write book to \"" << path.string() << "\"");
+			return false;
+		}
+	}
+
+	LOG(
+		" > Positions: " << Util::NumToStr(keys.size()) <<
+		", size: " << (size / (1024.0 * 1024.0)) << "MB (" << (size * 8.0 / keys.size()) << " bits/position)" <<
+		", hash levels: " << header.hash.numLevels << ", fallback keys: " << header.hash.numFallbackKeys
+	);
+	LOG(" > Enumerate time: " << enumerateTime << "s, hash time: " << hashTime << "s, solve time: " << solveTime << "s");
+	return true;
+}
+
+bool Book::Load(const std::filesystem::path& path) {
+	MappedFile newFile = {};
+	if (!newFile.Open(path, MappedFile::READ_ONLY))
+		return false;
+
+	const FileHeader* header = (const FileHeader*)newFile.data;
+	bool headerMatches =
+		newFile.size >= sizeof(FileHeader) &&
+		!memcmp(header->magic, FILE_MAGIC, sizeof(header->magic)) &&
+		header->version == FILE_VERSION &&
+		header->boardSizeX == BOARD_SIZE_X && header->boardSizeY == BOARD_SIZE_Y &&
+		header->connectWinAmount == CONNECT_WIN_AMOUNT &&
+		header->rootPly <= header->maxPly && header->maxPly < BOARD_CELL_COUNT;
+
+	BoardState root;
+	headerMatches = headerMatches && BoardState::FromKey(header->rootKey, root) && root.moveCount == (int)header->rootPly;
+
+	// Every array GetIndex() and Probe() read must lie within the file
+	headerMatches =
+		headerMatches &&
+		PerfectHash::IsValid(header->hash, newFile.size) &&
+		Util::IsRangeInSize(header->valuesOffset, (header->hash.count + 3) / 4, 1, newFile.size);
+
+	if (!headerMatches) {
+		WARN("Rejected book file \"" << path.string() << "\"");
+		return false;
+	}
+
+	file = std::move(newFile);
+	return true;
+}
+
+bool Book::CoversSubtree(const BoardState& board) const {
+	if (!IsLoaded() || board.moveCount > (int)GetHeader().maxPly)
+		return false;
+
+	BoardState root;
+	BoardState::FromKey(GetHeader().rootKey, root);
+	return Enumerate::IsInSubtree(root, board);
+}
+
+bool Book::Probe(const BoardState& board, Value& outValue) const {
+	if (!CoversPly(board.moveCount))
+		return false;
+
+	uint64_t index = PerfectHash::GetIndex(GetHeader().hash, file.data, board.GetCanonicalKey());
+	uint8_t packedValue = (GetData<uint8_t>(GetHeader().valuesOffset)[index / 4] >> ((index % 4) * 2)) & 3;
+	outValue = Value((int8_t)packedValue - 1, BOARD_CELL_COUNT - board.moveCount);
+	return true;
+}
+
+bool Book::ProbeBestMove(const BoardState& board, BoardMask& outMove, Value& outValue) const {
+	BoardMask validMoves = board.GetValidMoveMask();
+	if (!CoversPly(board.moveCount + 1) || !validMoves || (validMoves & board.winMasks[board.turnSwitch]))
+		return false;
+
+	outMove = 0;
+	auto moveItr = MoveIterator(validMoves);
+	while (BoardMask move = moveItr.GetNext()) {
+		BoardState nextBoard = board;
+		nextBoard.FillMove(move);
+
+		Value nextValue;
+		if (!Probe(nextBoard, nextValue))
+			return false;
+
+		if (!outMove || -nextValue > outValue) {
+			outMove = move;
+			outValue = -nextValue;
+		}
+	}
+
+	return true;
+}
+
+double Book::MeasureProbeLatency(int numProbes) const {
+	// Random games from the root, stopped at a random covered ply
+	std::mt19937_64 rng = std::mt19937_64(0);
+	BoardState root;
+	BoardState::FromKey(GetHeader().rootKey, root);
+
+	std::vector<BoardState> boards;
+	while (boards.size() < (size_t)numProbes) {
+		BoardState board = root;
+		int targetPly = GetHeader().rootPly + rng() % (GetHeader().maxPly - GetHeader().rootPly + 1);
+		while (board.moveCount < targetPly) {
+			BoardMask moves = board.GetValidMoveMask() & ~board.winMasks[board.turnSwitch];
+			if (!moves)
+				break;
+
+			int numMoves = Util::BitCount64(moves);
+			auto moveItr = MoveIterator(moves);
+			for (int i = rng() % numMoves; i > 0; i--)
+				moveItr.GetNext();
+			board.FillMove(moveItr.GetNext());
+		}
+
+		if (board.moveCount == targetPly)
+			boards.push_back(board);
+	}
+
+	Timer timer = {};
+	int64_t valueSum = 0;
+	for (const BoardState& board : boards) {
+		Value value;
+		Probe(board, value);
+		valueSum += value.val;
+	}
+	double time = timer.Elapsed();
+
+	RASSERT(std::abs(valueSum) <= numProbes, "Book probes failed");
+	return time * 1e9 / numProbes;
+}
\ No newline at end of file
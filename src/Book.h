@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Eval.h"
+#include "MappedFile.h"
+#include "PerfectHash.h"
+
+// Win/draw/loss opening book of every position from a root position up to a ply, at 2 bits per value
+// Keys aren't stored: a minimal perfect hash (PerfectHash) maps each canonical key to a unique index in the value array
+//
+// As keys aren't stored, a position that isn't in the book probes as an arbitrary value
+// Only probe positions of the book's plies reachable from its root (with the game still going),
+// searches check CoversSubtree() on their root before using the book
+struct Book {
+	constexpr static char FILE_MAGIC[8] = "C4BOOK";
+	constexpr static uint32_t FILE_VERSION = 1;
+
+	// Side to move's result
+	enum PackedValue : uint8_t {
+		PACKED_LOSS, PACKED_DRAW, PACKED_WIN
+	};
+
+	struct FileHeader {
+		char magic[8];
+		uint32_t version;
+		uint8_t boardSizeX, boardSizeY, connectWinAmount, pad;
+		uint32_t rootPly, maxPly;
+		uint64_t rootKey; // Canonical key of the root
+		PerfectHash::Header hash;
+		uint64_t valuesOffset; // 4 values per byte
+	};
+
+	struct BuildConfig {
+		std::string rootMoves = {};
+		int maxPly = 12;
+		int numThreads = 1;
+		int tableSizeLog2 = 22; // Per thread, kept warm across positions
+	};
+
+	Book() = default;
+	Book(const Book& other) = delete;
+	Book& operator=(const Book& other) = delete;
+
+	// Enumerates the positions and solves each one
+	static bool Build(const std::filesystem::path& path, const BuildConfig& config);
+
+	// Memory-maps a built book
+	bool Load(const std::filesystem::path& path);
+
+	bool IsLoaded() const {
+		return file.IsOpen();
+	}
+
+	bool CoversPly(int ply) const {
+		return IsLoaded() && ply >= (int)GetHeader().rootPly && ply <= (int)GetHeader().maxPly;
+	}
+
+	// Whether the board is reachable from the book's root (or its mirror image) and not past the book's plies,
+	// so every covered position a search from it reaches is in the book
+	bool CoversSubtree(const BoardState& board) const;
+
+	// Returns false if the position's ply isn't covered
+	// The depth of the value is the number of empty cells, an upper bound on the remaining moves
+	bool Probe(const BoardState& board, Value& outValue) const;
+
+	// Probes every move of a covered position, returns false if any of them isn't covered
+	bool ProbeBestMove(const BoardState& board, BoardMask& outMove, Value& outValue) const;
+
+	// Average nanoseconds per probe of positions in the book
+	double MeasureProbeLatency(int numProbes = 1'000'000) const;
+
+private:
+	MappedFile file;
+
+	const FileHeader& GetHeader() const {
+		return *(const FileHeader*)file.data;
+	}
+
+	template <typename T>
+	const T* GetData(uint64_t offset) const {
+		return (const T*)(file.data + offset);
+	}
+};
\ No newline at end of file
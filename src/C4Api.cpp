@@ -0,0 +1,213 @@
+#include "C4Api.h"
+
+#include "Search.h"
+#include "ParallelSearch.h"
+#include "PositionFile.h"
+#include "Tablebase.h"
+#include "Book.h"
+
+static_assert(sizeof(C4Result) == 16, "C4Result layout changed");
+static_assert(C4_NUM_COLUMNS == BOARD_SIZE_X, "The C interface is built for 7 columns");
+
+struct C4Solver {
+	std::unique_ptr<TranspositionTable> table;
+	int numThreads;
+	Tablebase tablebase;
+	Book book;
+
+	const Tablebase* GetTablebase() const {
+		return tablebase.IsLoaded() ? &tablebase : NULL;
+	}
+
+	const Book* GetBook() const {
+		return book.IsLoaded() ? &book : NULL;
+	}
+};
+
+// No exception may cross into C callers
+template <typename T>
+static int32_t Guard(T fnCall) {
+	try {
+		return fnCall();
+	} catch (...) {
+		return C4_ERROR_INTERNAL;
+	}
+}
+
+static bool HasConnectedWin(BoardMask team) {
+	// A piece that would complete a line is already part of one
+	return team.MakeWinMask() & team;
+}
+
+static int32_t UnpackPlayable(uint64_t position, BoardState& outBoard) {
+	if (!PackedPosition::Unpack(position, outBoard))
+		return C4_ERROR_INVALID_POSITION;
+
+	if (HasConnectedWin(outBoard.teams[0]) || HasConnectedWin(outBoard.teams[1]) || !outBoard.GetValidMoveMask())
+		return C4_ERROR_GAME_OVER;
+
+	return C4_OK;
+}
+
+static C4Result MakeResult(int32_t status, Value eval = {}, BoardMask move = 0, uint64_t nodes = 0) {
+	C4Result result = {};
+	result.status = status;
+	result.value = (status == C4_OK) ? eval.val : 0;
+	result.bestMove = move ? (int8_t)(Util::BitMaskToIndex(move) / 8) : -1;
+	result.nodes = nodes;
+	return result;
+}
+
+// Both searches only use the book and tablebase if the position is in their subtree (CoversSubtree), as they can't tell positions apart otherwise
+static C4Result SolveBoard(C4Solver* solver, const BoardState& board, int numThreads) {
+	SearchResult searchResult;
+	if (numThreads > 1) {
+		ParallelSearch::Config config = {};
+		config.numThreads = numThreads;
+		config.tablebase = solver->GetTablebase();
+		config.book = solver->GetBook();
+		searchResult = ParallelSearch::Search(solver->table.get(), board, config, false);
+	} else {
+		searchResult = Search::Search(solver->table.get(), board, false, solver->GetTablebase(), solver->GetBook());
+	}
+
+	return MakeResult(C4_OK, searchResult.eval, searchResult.move, searchResult.totalSearched);
+}
+
+uint32_t c4_api_version(void) {
+	return C4_API_VERSION;
+}
+
+void c4_default_config(C4Config* outConfig) {
+	if (!outConfig)
+		return;
+
+	*outConfig = {};
+	outConfig->tableSizeMBs = TranspositionTable::DEFAULT_SIZE_MBS;
+	outConfig->numThreads = 1;
+}
+
+C4Solver* c4_create(const C4Config* config) {
+	C4Config defaultConfig;
+	c4_default_config(&defaultConfig);
+	if (!config)
+		config = &defaultConfig;
+
+	if (config->numThreads < 1 || config->numThreads > ParallelSearch::MAX_THREADS)
+		return NULL;
+
+	static std::once_flag evalInitFlag;
+	try {
+		std::call_once(evalInitFlag, [] { Eval::Init(false); });
+
+		size_t numEntries = MAX(config->tableSizeMBs * 1'000'000 / sizeof(TranspositionTable::Entry), (size_t)1);
+		auto solver = std::make_unique<C4Solver>();
+		solver->table = std::make_unique<TranspositionTable>(std::bit_width(numEntries) - 1);
+		solver->numThreads = config->numThreads;
+
+		if (config->tablebasePath && !solver->tablebase.Load(config->tablebasePath))
+			return NULL;
+		if (config->bookPath && !solver->book.Load(config->bookPath))
+			return NULL;
+
+		return solver.release();
+	} catch (...) {
+		return NULL;
+	}
+}
+
+void c4_destroy(C4Solver* solver) {
+	delete solver;
+}
+
+int32_t c4_encode_moves(const char* moves, uint64_t* outPosition) {
+	if (!moves || !outPosition)
+		return C4_ERROR_INVALID_ARGUMENT;
+
+	return Guard([&]() -> int32_t {
+		return PackedPosition::FromMoveString(moves, *outPosition) ? C4_OK : C4_ERROR_INVALID_POSITION;
+	});
+}
+
+int32_t c4_solve(C4Solver* solver, uint64_t position, C4Result* outResult) {
+	if (!solver || !outResult)
+		return C4_ERROR_INVALID_ARGUMENT;
+
+	return Guard([&]() -> int32_t {
+		BoardState board;
+		int32_t status = UnpackPlayable(position, board);
+		*outResult = (status == C4_OK) ? SolveBoard(solver, board, solver->numThreads) : MakeResult(status);
+		return status;
+	});
+}
+
+int32_t c4_analyze(C4Solver* solver, uint64_t position, C4Result outResults[C4_NUM_COLUMNS]) {
+	if (!solver || !outResults)
+		return C4_ERROR_INVALID_ARGUMENT;
+
+	return Guard([&]() -> int32_t {
+		BoardState board;
+		int32_t status = UnpackPlayable(position, board);
+		if (status != C4_OK) {
+			for (int x = 0; x < BOARD_SIZE_X; x++)
+				outResults[x] = MakeResult(status);
+			return status;
+		}
+
+		for (int x = 0; x < BOARD_SIZE_X; x++) {
+			if (!board.IsMoveValid(x)) {
+				outResults[x] = MakeResult(C4_ERROR_INVALID_MOVE);
+				continue;
+			}
+
+			BoardMask move = board.GetValidMoveMask() & BoardMask::GetColumnMask(x);
+			if (move & board.winMasks[board.turnSwitch]) {
+				outResults[x] = MakeResult(C4_OK, Value(1), move);
+				continue;
+			}
+
+			BoardState nextBoard = board;
+			nextBoard.FillMove(move);
+			if (!nextBoard.GetValidMoveMask()) {
+				outResults[x] = MakeResult(C4_OK, Value(0), move);
+				continue;
+			}
+
+			// The opponent's value, from our side
+			C4Result nextResult = SolveBoard(solver, nextBoard, solver->numThreads);
+			outResults[x] = MakeResult(C4_OK, Value(-nextResult.value), move, nextResult.nodes);
+		}
+
+		return C4_OK;
+	});
+}
+
+int32_t c4_solve_batch(C4Solver* solver, const uint64_t* positions, size_t count, C4Result* outResults) {
+	if (!solver || (count && (!positions || !outResults)))
+		return C4_ERROR_INVALID_ARGUMENT;
+
+	return Guard([&]() -> int32_t {
+		// Each thread solves whole positions, as independent positions scale better than splitting one
+		std::atomic<size_t> nextIndex = 0;
+		auto fnWork = [&]() {
+			for (size_t i = nextIndex++; i < count; i = nextIndex++) {
+				try {
+					BoardState board;
+					int32_t status = UnpackPlayable(positions[i], board);
+					outResults[i] = (status == C4_OK) ? SolveBoard(solver, board, 1) : MakeResult(status);
+				} catch (...) {
+					outResults[i] = MakeResult(C4_ERROR_INTERNAL);
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (int i = 1; i < (int)MIN((size_t)solver->numThreads, count); i++)
+			threads.push_back(std::thread(fnWork));
+		fnWork();
+		for (auto& thread : threads)
+			thread.join();
+
+		return C4_OK;
+	});
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+// C interface for embedding the solver in other programs and languages (Python ctypes/cffi, Go cgo, ...)
+// Built as a shared library from every source file except Main.cpp, with C4_BUILD_LIBRARY defined (see README.md)
+//
+// Positions are 8-byte packed positions (PositionFile.h):
+//	Bits 0-55	Turn player's pieces plus a bit above each column's top piece, 8 bits per column
+//	Bits 56-61	Ply (move count)
+//	Bit 62		Mirrored, the key is of the position's mirror image
+//	Bit 63		Reserved, always 0
+// c4_encode_moves() makes them from move strings
+//
+// Every call is thread-safe: calls on the same solver share its transposition table (updated lock-free)
+// A solver must not be destroyed while calls on it are still running
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(_WIN32)
+#if defined(C4_BUILD_LIBRARY)
+#define C4_API __declspec(dllexport)
+#else
+#define C4_API __declspec(dllimport)
+#endif
+#else
+#define C4_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bumped whenever a signature or struct layout changes
+#define C4_API_VERSION 1
+
+#define C4_NUM_COLUMNS 7
+
+// Returned by every call, and per position in results
+enum C4Status {
+	C4_OK = 0,
+	C4_ERROR_INVALID_ARGUMENT = 1, // Null pointer or bad config
+	C4_ERROR_INVALID_POSITION = 2, // Not a valid packed position (or move string)
+	C4_ERROR_GAME_OVER = 3, // The position is already won or full, there is nothing to solve
+	C4_ERROR_INVALID_MOVE = 4, // c4_analyze(): the column is full
+	C4_ERROR_INTERNAL = 5
+};
+
+typedef struct C4Solver C4Solver;
+
+typedef struct C4Config {
+	uint64_t tableSizeMBs; // Rounded down to a power of two entries
+	int32_t numThreads; // Threads per single solve, and positions solved at once by c4_solve_batch()
+	int32_t reserved;
+
+	// Optional (NULL for none), memory-mapped files built with -buildtablebase and -buildbook
+	const char* tablebasePath;
+	const char* bookPath;
+} C4Config;
+
+// 16 bytes, results are from the perspective of the side to move
+typedef struct C4Result {
+	int32_t status; // C4Status
+	int8_t value; // 1 win, 0 draw, -1 loss
+	int8_t bestMove; // Column from 0, -1 if there is none
+	uint16_t reserved;
+	uint64_t nodes; // Positions searched
+} C4Result;
+
+C4_API uint32_t c4_api_version(void);
+C4_API void c4_default_config(C4Config* outConfig);
+
+// Returns NULL on failure, config may be NULL for the defaults
+C4_API C4Solver* c4_create(const C4Config* config);
+C4_API void c4_destroy(C4Solver* solver);
+
+// Move string of columns from '1', as on the command line
+C4_API int32_t c4_encode_moves(const char* moves, uint64_t* outPosition);
+
+C4_API int32_t c4_solve(C4Solver* solver, uint64_t position, C4Result* outResult);
+
+// Value of every move (outResults[x] for column x), full columns get C4_ERROR_INVALID_MOVE
+C4_API int32_t c4_analyze(C4Solver* solver, uint64_t position, C4Result outResults[C4_NUM_COLUMNS]);
+
+// Solves every position into outResults[i] in place, with each result's own status
+// Returns an error only if the arguments are invalid
+C4_API int32_t c4_solve_batch(C4Solver* solver, const uint64_t* positions, size_t count, C4Result* outResults);
+
+#ifdef __cplusplus
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include "Checkpoint.h"
+#include "Book.h"
+#include "Tablebase.h"
+
+namespace fs = std::filesystem;
+
+using BoundType = TranspositionTable::BoundType;
+
+// By BoundType
+constexpr char BOUND_CHARS[] = { 'E', 'L', 'U' };
+static_assert(TranspositionTable::BOUND_EXACT == 0 && TranspositionTable::BOUND_LOWER == 1 && TranspositionTable::BOUND_UPPER == 2);
+
+struct CheckpointRecord {
+	Value eval; // From the perspective of the node the move was played from
+	BoundType bound;
+};
+
+struct CheckpointContext {
+	TranspositionTable* table;
+	fs::path checkpointDir;
+	std::ofstream recordStream;
+	std::unordered_map<std::string, CheckpointRecord> records;
+	SearchInfo searchInfo = {};
+
+	bool saveTable;
+	double snapshotInterval;
+	Timer snapshotTimer = {};
+
+	int numReplayed = 0;
+
+	void SaveTableSnapshot() {
+		Timer timer = {};
+		if (table->Save(checkpointDir / "table.bin"))
+			LOG(" > Saved table snapshot in " << timer.Elapsed() << "s");
+	}
+
+	void AddRecord(const std::string& movePath, CheckpointRecord record) {
+		recordStream << movePath << " " << (int)record.eval.val << " " << (int)record.eval.depth << " " << BOUND_CHARS[record.bound] << std::endl;
+		records[movePath] = record;
+
+		if (saveTable && snapshotTimer.Elapsed() > snapshotInterval) {
+			SaveTableSnapshot();
+			snapshotTimer.Reset();
+		}
+	}
+};
+
+// movePath is the move string from the root to this board
+static Value SearchCheckpointed(CheckpointContext& ctx, const BoardState& board, SearchCache cache, const std::string& movePath, int level) {
+	if (level >= Checkpoint::NUM_CHECKPOINT_LEVELS)
+		return Search::AlphaBetaSearch(ctx.table, board, ctx.searchInfo, cache);
+
+	BoardMask validMovesMask = board.GetValidMoveMask();
+	Value bestEval = Eval::EvalAndCropValidMoves(board, validMovesMask);
+	if (bestEval != VALUE_INVALID)
+		return bestEval;
+
+	// Same order every run (regardless of the config's weights), so replayed results leave the window exactly as it was
+	BoardMask moves[BOARD_SIZE_X];
+	int numMoves = Search::GetOrderedMoves(board, validMovesMask, 0, moves);
+
+	BoardMask bestMove = 0;
+	for (int i = 0; i < numMoves; i++) {
+		BoardMask move = moves[i];
+		std::string nextMovePath = movePath + (char)('1' + Util::BitMaskToIndex(move) / 8);
+
+		Value nextEval;
+		auto recordItr = ctx.records.find(nextMovePath);
+		if (recordItr != ctx.records.end()) {
+			nextEval = recordItr->second.eval;
+			ctx.numReplayed++;
+		} else {
+			BoardState nextBoard = board;
+			nextBoard.FillMove(move);
+
+			nextEval = -SearchCheckpointed(ctx, nextBoard, cache.ProgressDepth(), nextMovePath, level + 1);
+			nextEval.depth++;
+
+			BoundType bound = TranspositionTable::BOUND_EXACT;
+			if (nextEval >= cache.max) {
+				bound = TranspositionTable::BOUND_LOWER;
+			} else if (nextEval <= cache.min) {
+				bound = TranspositionTable::BOUND_UPPER;
+			}
+			ctx.AddRecord(nextMovePath, { nextEval, bound });
+		}
+
+		if (nextEval >= cache.max) {
+			bestEval = nextEval;
+			bestMove = move;
+			break;
+		}
+
+		if (nextEval > bestEval) {
+			bestEval = nextEval;
+
+			if (nextEval > cache.min)
+				cache.min = nextEval;
+
+			bestMove = move;
+		}
+	}
+
+	if (level == 0)
+		ctx.searchInfo.bestMove[0] = bestMove;
+
+	return bestEval;
+}
+
+SearchResult Checkpoint::Search(
+	TranspositionTable* table, const BoardState& board, const fs::path& checkpointDir,
+	bool saveTable, bool log, const Tablebase* tablebase, const Book* book,
+	const SearchConfig& config, double snapshotInterval) {
+
+	BoardMask validMoves = board.GetValidMoveMask();
+	RASSERT(validMoves, "No valid moves in the position");
+
+	if (validMoves & board.winMasks[board.turnSwitch])
+		return Search::Search(table, board, log, tablebase, book, {}, config); // Nothing to checkpoint
+
+	// Positions outside the book's or tablebase's subtree would probe as arbitrary values
+	if (book && !book->CoversSubtree(board))
+		book = NULL;
+	if (tablebase && !tablebase->CoversSubtree(board))
+		tablebase = NULL;
+
+	Timer timer = {};
+	fs::create_directories(checkpointDir);
+
+	CheckpointContext ctx = {};
+	ctx.table = table;
+	ctx.checkpointDir = checkpointDir;
+	ctx.saveTable = saveTable;
+	ctx.snapshotInterval = snapshotInterval;
+	ctx.searchInfo.tablebase = tablebase;
+	ctx.searchInfo.book = book;
+	ctx.searchInfo.config = &config;
+
+	fs::path recordsPath = checkpointDir / "records.txt";
+	std::string positionLine = STR("position " << std::hex << board.GetKey());
+	bool hasPositionLine = false;
+	{
+		std::string contents;
+		{
+			std::ifstream stream = std::ifstream(recordsPath, std::ios::binary);
+			contents.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+		}
+
+		// Drop a line partially written before a crash, appending to it would corrupt the next record
+		size_t endPos = contents.rfind('\n');
+		endPos = (endPos == std::string::npos) ? 0 : (endPos + 1);
+		if (endPos < contents.size()) {
+			contents.resize(endPos);
+			fs::resize_file(recordsPath, endPos);
+		}
+
+		std::stringstream stream = std::stringstream(contents);
+		std::string line;
+		if (std::getline(stream, line)) {
+			if (line != positionLine)
+				ERR_CLOSE("Checkpoint at \"" << checkpointDir.string() << "\" is for a different position (" << line << ")");
+			hasPositionLine = true;
+
+			while (std::getline(stream, line)) {
+				std::stringstream lineStream = std::stringstream(line);
+				std::string movePath;
+				int val, depth;
+				char boundChar = 0;
+				lineStream >> movePath >> val >> depth >> boundChar;
+				if (!lineStream)
+					continue;
+
+				auto boundCharItr = std::find(std::begin(BOUND_CHARS), std::end(BOUND_CHARS), boundChar);
+				if (boundCharItr == std::end(BOUND_CHARS))
+					continue;
+
+				ctx.records[movePath] = { Value(val, depth), (BoundType)(boundCharItr - std::begin(BOUND_CHARS)) };
+			}
+		}
+	}
+
+	bool resuming = !ctx.records.empty();
+	ctx.recordStream = std::ofstream(recordsPath, std::ios::app);
+	if (!hasPositionLine)
+		ctx.recordStream << positionLine << std::endl;
+
+	if (saveTable && resuming && table->Load(checkpointDir / "table.bin")) {
+		if (log)
+			LOG("Loaded table snapshot");
+	}
+
+	if (log && resuming)
+		LOG("Resuming from checkpoint with " << ctx.records.size() << " records");
+
+	Value eval = SearchCheckpointed(ctx, board, {}, "", 0);
+	double timeElapsed = timer.Elapsed();
+
+	BoardMask bestMove = ctx.searchInfo.bestMove[0];
+	if (!bestMove)
+		bestMove = MoveIterator(validMoves).GetNext();
+
+	if (saveTable)
+		ctx.SaveTableSnapshot();
+
+	if (log) {
+		LOG(
+			"Eval: " << eval <<
+			", searched: " << Util::NumToStr(ctx.searchInfo.totalSearched) <<
+			", replayed: " << ctx.numReplayed <<
+			", time: " << timeElapsed << "s"
+		);
+		LOG(" > Best move: " << (Util::BitMaskToIndex(bestMove) / 8 + 1));
+	}
+
+	SearchResult result = { bestMove, eval, ctx.searchInfo.totalSearched };
+#if SEARCH_STATS
+	result.stats = ctx.searchInfo.stats;
+	if (log)
+		result.stats.Log();
+#endif
+	return result;
+}
\ No newline at end of file
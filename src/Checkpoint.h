@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Search.h"
+
+// Resumable solving
+// Results of the root's moves and their moves are recorded to a checkpoint directory as they finish,
+// a restarted solve replays them and continues where it left off with the same window
+namespace Checkpoint {
+	// Root moves and their moves are checkpointed, everything below is searched normally
+	constexpr int NUM_CHECKPOINT_LEVELS = 2;
+
+	// Minimum time between table snapshots
+	constexpr double DEFAULT_SNAPSHOT_INTERVAL = 30 * 60;
+
+	// Single-threaded, the tablebase, book and config only apply below the checkpointed levels
+	SearchResult Search(
+		TranspositionTable* table, const BoardState& board, const std::filesystem::path& checkpointDir,
+		bool saveTable, bool log, const Tablebase* tablebase = NULL, const Book* book = NULL,
+		const SearchConfig& config = DEFAULT_SEARCH_CONFIG, double snapshotInterval = DEFAULT_SNAPSHOT_INTERVAL
+	);
+}
\ No newline at end of file
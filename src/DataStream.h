@@ -16,4 +16,22 @@ struct DataStream {
 	void WriteRaw(const void* ptr, size_t size) {
 		stream.write((char*)ptr, size);
 	}
+};
+
+struct DataReadStream {
+	std::ifstream stream;
+	DataReadStream(std::filesystem::path path) {
+		stream = std::ifstream(path, std::ios::binary);
+	}
+
+	template<typename T>
+	bool Read(T& outVal) {
+		return (bool)stream.read((char*)&outVal, sizeof(outVal));
+	}
+
+	// Returns the number of bytes read, which is less than size at the end of the stream
+	size_t ReadRaw(void* ptr, size_t size) {
+		stream.read((char*)ptr, size);
+		return stream.gcount();
+	}
 };
\ No newline at end of file
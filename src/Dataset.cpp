@@ -0,0 +1,321 @@
+#include "Dataset.h"
+#include "Testing.h"
+
+// Records each thread gathers before writing them out
+constexpr size_t THREAD_BLOCK_SIZE = 1024;
+
+// Random generation gives up after this many duplicates per position asked for
+constexpr uint64_t MAX_DUPLICATES_PER_POSITION = 100;
+
+constexpr double PROGRESS_LOG_INTERVAL = 10;
+
+static_assert((BOARD_SIZE_X + 1) * Dataset::PACKED_VALUE_BITS <= 16, "Packed values don't fit in 2 bytes");
+
+static void WriteVarint(std::vector<uint8_t>& bytes, uint64_t val) {
+	for (; val >= 0x80; val >>= 7)
+		bytes.push_back((uint8_t)(val | 0x80));
+	bytes.push_back((uint8_t)val);
+}
+
+static bool ReadVarint(const uint8_t*& itr, const uint8_t* end, uint64_t& outVal) {
+	outVal = 0;
+	for (int shift = 0; itr < end && shift < 64; shift += 7) {
+		uint8_t byte = *(itr++);
+		outVal |= (uint64_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+// Sorts the records, as close positions have small differences
+static std::vector<uint8_t> CompressBlock(std::vector<Dataset::Record>& records) {
+	std::sort(records.begin(), records.end(),
+		[](const Dataset::Record& a, const Dataset::Record& b) { return a.position < b.position; }
+	);
+
+	std::vector<uint8_t> bytes;
+	uint64_t prevPosition = 0;
+	for (const Dataset::Record& record : records) {
+		WriteVarint(bytes, record.position - prevPosition);
+		prevPosition = record.position;
+
+		uint16_t values = record.eval;
+		for (int x = 0; x < BOARD_SIZE_X; x++)
+			values |= (uint16_t)record.moveEvals[x] << ((x + 1) * Dataset::PACKED_VALUE_BITS);
+		bytes.push_back((uint8_t)values);
+		bytes.push_back((uint8_t)(values >> 8));
+	}
+	return bytes;
+}
+
+static bool DecompressBlock(const std::vector<uint8_t>& bytes, uint32_t count, std::vector<Dataset::Record>& outRecords) {
+	const uint8_t* itr = bytes.data();
+	const uint8_t* end = itr + bytes.size();
+	uint64_t position = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		uint64_t diff;
+		if (!ReadVarint(itr, end, diff) || end - itr < 2)
+			return false;
+
+		position += diff;
+		uint16_t values = itr[0] | (itr[1] << 8);
+		itr += 2;
+
+		Dataset::Record record = {};
+		record.position = position;
+		record.eval = values & Dataset::PACKED_VALUE_NONE;
+		for (int x = 0; x < BOARD_SIZE_X; x++)
+			record.moveEvals[x] = (values >> ((x + 1) * Dataset::PACKED_VALUE_BITS)) & Dataset::PACKED_VALUE_NONE;
+		outRecords.push_back(record);
+	}
+
+	return itr == end;
+}
+
+Dataset::Record Dataset::SolveRecord(TranspositionTable* table, const BoardState& board) {
+	Record record = {};
+	record.position = PackedPosition::Pack(board);
+	std::fill(record.moveEvals, record.moveEvals + BOARD_SIZE_X, PACKED_VALUE_NONE);
+
+	BoardMask selfWinMask = board.winMasks[board.turnSwitch];
+	Value bestEval = VALUE_INVALID;
+
+	auto moveItr = MoveIterator(board.GetValidMoveMask());
+	while (BoardMask move = moveItr.GetNext()) {
+		Value eval;
+		if (move & selfWinMask) {
+			eval = Value(1, 1);
+		} else {
+			BoardState nextBoard = board;
+			nextBoard.FillMove(move);
+
+			if (nextBoard.GetValidMoveMask() & nextBoard.winMasks[nextBoard.turnSwitch]) {
+				// The opponent wins right away (the search never sees nodes with an immediate win)
+				eval = Value(-1, 2);
+			} else {
+				SearchInfo searchInfo = {};
+				eval = -Search::AlphaBetaSearch(table, nextBoard, searchInfo);
+				eval.depth++;
+			}
+		}
+
+		record.moveEvals[Util::BitMaskToIndex(move) / 8] = PackValue(eval);
+		if (bestEval == VALUE_INVALID || eval > bestEval)
+			bestEval = eval;
+	}
+
+	record.eval = PackValue(bestEval);
+	return record;
+}
+
+// Every position at the ply where nobody has won yet, by canonical key
+static std::vector<uint64_t> EnumeratePositions(int ply) {
+	std::vector<BoardState> boards = { BoardState() };
+	for (int i = 0; i < ply; i++) {
+		std::unordered_set<uint64_t> seen;
+		std::vector<BoardState> nextBoards;
+		for (const BoardState& board : boards) {
+			BoardMask winMask = board.winMasks[board.turnSwitch];
+			auto moveItr = MoveIterator(board.GetValidMoveMask() & ~winMask);
+			while (BoardMask move = moveItr.GetNext()) {
+				BoardState nextBoard = board;
+				nextBoard.FillMove(move);
+				if (seen.insert(nextBoard.GetCanonicalKey()).second)
+					nextBoards.push_back(nextBoard);
+			}
+		}
+		boards = std::move(nextBoards);
+	}
+
+	std::vector<uint64_t> result;
+	result.reserve(boards.size());
+	for (const BoardState& board : boards)
+		result.push_back(PackedPosition::Pack(board, true));
+	return result;
+}
+
+struct DatasetWriter {
+	std::mutex mutex;
+	DataStream stream;
+	uint64_t count = 0;
+	uint64_t numBytes = 0; // Of the blocks
+
+	DatasetWriter(const std::filesystem::path& path) : stream(path) {
+		WriteHeader();
+	}
+
+	void WriteHeader() {
+		Dataset::FileHeader header = {};
+		memcpy(header.magic, Dataset::FILE_MAGIC, sizeof(header.magic));
+		header.version = Dataset::FILE_VERSION;
+		header.boardSizeX = BOARD_SIZE_X;
+		header.boardSizeY = BOARD_SIZE_Y;
+		header.count = count;
+		stream.Write(header);
+	}
+
+	void Write(std::vector<Dataset::Record>& records) {
+		if (records.empty())
+			return;
+
+		std::vector<uint8_t> bytes = CompressBlock(records);
+		Dataset::BlockHeader blockHeader = { (uint32_t)records.size(), (uint32_t)bytes.size() };
+
+		std::lock_guard<std::mutex> lock(mutex);
+		stream.Write(blockHeader);
+		stream.WriteRaw(bytes.data(), bytes.size());
+		count += records.size();
+		numBytes += sizeof(blockHeader) + bytes.size();
+		records.clear();
+	}
+
+	bool Close() {
+		stream.stream.seekp(0);
+		WriteHeader();
+		stream.stream.close();
+		return !stream.stream.fail();
+	}
+};
+
+bool Dataset::Generate(const std::filesystem::path& path, const Config& config) {
+	RASSERT(config.ply >= 0 && config.ply < BOARD_CELL_COUNT, "Bad dataset ply: " << config.ply);
+	RASSERT(config.numThreads >= 1, "Bad thread count: " << config.numThreads);
+
+	DatasetWriter writer = DatasetWriter(path);
+	if (!writer.stream.stream) {
+		WARN("Failed to create dataset file \"" << path.string() << "\"");
+		return false;
+	}
+
+	bool exhaustive = (config.numPositions == 0);
+	std::vector<uint64_t> positions;
+	if (exhaustive) {
+		positions = EnumeratePositions(config.ply);
+		LOG("Generating dataset of all " << positions.size() << " unique positions at ply " << config.ply << "...");
+	} else {
+		LOG("Generating dataset of " << config.numPositions << " random positions at ply " << config.ply << "...");
+	}
+	uint64_t targetCount = exhaustive ? positions.size() : config.numPositions;
+
+	std::mutex seenMutex;
+	std::unordered_set<uint64_t> seen;
+	std::atomic<uint64_t> numClaimed = 0, numDuplicates = 0, numSolved = 0;
+
+	auto fnWork = [&](int threadIndex) {
+		TranspositionTable table = TranspositionTable(config.tableSizeLog2);
+		std::seed_seq seedSeq = { config.seed, (uint64_t)threadIndex };
+		std::mt19937_64 rng = std::mt19937_64(seedSeq);
+		std::vector<Record> records;
+
+		while (true) {
+			uint64_t index = numClaimed++;
+			if (index >= targetCount)
+				break;
+
+			BoardState board;
+			if (exhaustive) {
+				PackedPosition::Unpack(positions[index] & ~PackedPosition::MIRRORED_BIT, board);
+			} else {
+				// Keep drawing until we find a position nobody has taken
+				bool found = false;
+				while (!found && numDuplicates < targetCount * MAX_DUPLICATES_PER_POSITION) {
+					BoardState randomBoard = Testing::GeneratePosition(config.ply, rng);
+					// Both orientations pack to the same key, only the mirrored bit tells them apart
+					uint64_t packed = PackedPosition::Pack(randomBoard, true) & ~PackedPosition::MIRRORED_BIT;
+					{
+						std::lock_guard<std::mutex> lock(seenMutex);
+						found = seen.insert(packed).second;
+					}
+
+					if (found) {
+						PackedPosition::Unpack(packed, board);
+					} else {
+						numDuplicates++;
+					}
+				}
+
+				if (!found)
+					break;
+			}
+
+			records.push_back(SolveRecord(&table, board));
+			numSolved++;
+			if (records.size() >= THREAD_BLOCK_SIZE)
+				writer.Write(records);
+		}
+
+		writer.Write(records);
+	};
+
+	Timer timer = {};
+	std::vector<std::thread> threads;
+	for (int i = 0; i < config.numThreads; i++)
+		threads.push_back(std::thread(fnWork, i));
+
+	// Log progress until the workers are done
+	std::atomic<int> numFinished = 0;
+	std::thread progressThread = std::thread([&]() {
+		double lastLogTime = 0;
+		while (numFinished < config.numThreads) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			if (timer.Elapsed() - lastLogTime >= PROGRESS_LOG_INTERVAL) {
+				lastLogTime = timer.Elapsed();
+				LOG(" > Solved " << numSolved << "/" << targetCount << ", positions/sec: " << Util::NumToStr(numSolved / lastLogTime));
+			}
+		}
+	});
+
+	for (auto& thread : threads) {
+		thread.join();
+		numFinished++;
+	}
+	progressThread.join();
+
+	if (numSolved < targetCount)
+		WARN("Only found " << numSolved << " unique positions (" << numDuplicates << " duplicates drawn)");
+
+	double time = timer.Elapsed();
+	LOG(
+		" > Wrote " << writer.count << " records in " << time << "s (positions/sec: " << Util::NumToStr(writer.count / MAX(time, 1e-9)) <<
+		", bytes/record: " << ((double)writer.numBytes / MAX(writer.count, (uint64_t)1)) << ")"
+	);
+	return writer.Close();
+}
+
+bool Dataset::Read(const std::filesystem::path& path, std::vector<Record>& outRecords) {
+	DataReadStream stream = DataReadStream(path);
+	FileHeader header;
+	if (!stream.Read(header)) {
+		WARN("Failed to read dataset file \"" << path.string() << "\"");
+		return false;
+	}
+
+	if (memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) || header.version != FILE_VERSION) {
+		WARN("\"" << path.string() << "\" is not a dataset file of version " << FILE_VERSION);
+		return false;
+	}
+
+	if (header.boardSizeX != BOARD_SIZE_X || header.boardSizeY != BOARD_SIZE_Y) {
+		WARN("Dataset is for a " << (int)header.boardSizeX << "x" << (int)header.boardSizeY << " board");
+		return false;
+	}
+
+	outRecords.clear();
+	std::vector<uint8_t> bytes;
+	while (outRecords.size() < header.count) {
+		BlockHeader blockHeader;
+		if (!stream.Read(blockHeader) || blockHeader.count > header.count - outRecords.size()) {
+			WARN("Dataset \"" << path.string() << "\" is truncated or corrupt");
+			return false;
+		}
+
+		bytes.resize(blockHeader.numBytes);
+		if (stream.ReadRaw(bytes.data(), bytes.size()) != bytes.size() || !DecompressBlock(bytes, blockHeader.count, outRecords)) {
+			WARN("Dataset \"" << path.string() << "\" is truncated or corrupt");
+			return false;
+		}
+	}
+
+	return true;
+}
\ No newline at end of file
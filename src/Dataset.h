@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Search.h"
+#include "PositionFile.h"
+
+// Solved-position datasets: positions at a ply, each with its exact value and the value of every move
+// Positions are deduplicated by canonical key and stored in canonical orientation
+namespace Dataset {
+	constexpr char FILE_MAGIC[8] = "C4DATA";
+	constexpr uint32_t FILE_VERSION = 2;
+
+	// Values are win/draw/loss only, val + 1
+	// Depths are left out as they depend on the state of the table that solved them (they aren't the shortest)
+	constexpr uint8_t PACKED_VALUE_NONE = 3; // Not a valid move
+	constexpr int PACKED_VALUE_BITS = 2;
+
+	constexpr uint8_t PackValue(Value value) {
+		return (uint8_t)(value.val + 1);
+	}
+
+	constexpr Value UnpackValue(uint8_t packed) {
+		return Value((int8_t)packed - 1);
+	}
+
+	struct Record {
+		uint64_t position; // PackedPosition, never mirrored
+		uint8_t eval;
+		uint8_t moveEvals[BOARD_SIZE_X]; // From the side to move's perspective, by column
+	};
+
+	// Records are compressed in blocks, sorted by position
+	// Each record is the varint difference to the previous position, then the packed values in 2 bytes (eval in the low bits, then by column)
+	struct FileHeader {
+		char magic[8];
+		uint32_t version;
+		uint8_t boardSizeX, boardSizeY, pad[2];
+		uint64_t count;
+	};
+
+	struct BlockHeader {
+		uint32_t count;
+		uint32_t numBytes; // Of the compressed records that follow
+	};
+
+	struct Config {
+		int ply = 12;
+		uint64_t numPositions = 0; // 0 for every unique position at the ply
+		int numThreads = 1;
+		int tableSizeLog2 = 22; // Per thread, kept warm across positions
+		uint64_t seed = 0;
+	};
+
+	// Solves the position and each of its moves
+	Record SolveRecord(TranspositionTable* table, const BoardState& board);
+
+	// Returns false if the file couldn't be written
+	bool Generate(const std::filesystem::path& path, const Config& config);
+
+	// Returns false if the file couldn't be read or is invalid
+	bool Read(const std::filesystem::path& path, std::vector<Record>& outRecords);
+}
\ No newline at end of file
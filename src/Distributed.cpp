@@ -0,0 +1,281 @@
+#include "Distributed.h"
+
+namespace fs = std::filesystem;
+
+static std::string KeyToStr(uint64_t key) {
+	std::stringstream stream;
+	stream << std::hex << std::setw(16) << std::setfill('0') << key;
+	return stream.str();
+}
+
+static uint64_t StrToKey(const std::string& str) {
+	return std::stoull(str, NULL, 16);
+}
+
+// Writes to a temporary file first so readers never see partial files
+static void WriteFileAtomic(const fs::path& path, const std::string& contents) {
+	fs::path tempPath = path;
+	tempPath += ".tmp";
+	{
+		std::ofstream stream = std::ofstream(tempPath);
+		stream << contents;
+		if (!stream)
+			ERR_CLOSE("Failed to write \"" << tempPath << "\"");
+	}
+	fs::rename(tempPath, path);
+}
+
+struct JobRoot {
+	std::string moves;
+	int splitPly;
+
+	BoardState MakeBoard() const {
+		BoardState board = {};
+		board.PlayMoveString(moves);
+		return board;
+	}
+
+	static JobRoot Read(const fs::path& jobDir) {
+		std::ifstream stream = std::ifstream(jobDir / "root.txt");
+		if (!stream)
+			ERR_CLOSE("Failed to read job root from \"" << jobDir << "\"");
+
+		JobRoot root = {};
+		std::getline(stream, root.moves);
+		stream >> root.splitPly;
+		return root;
+	}
+};
+
+// Calls fn on every unique position at the split ply
+// Games that end before the split ply don't produce units
+static void ForEachSplitPosition(const BoardState& board, int splitPly, std::unordered_set<uint64_t>& visited, const std::function<void(const BoardState&)>& fn) {
+	if (board.moveCount >= splitPly) {
+		if (visited.insert(board.GetCanonicalKey()).second)
+			fn(board);
+		return;
+	}
+
+	BoardMask validMoves = board.GetValidMoveMask();
+	if (validMoves & board.winMasks[board.turnSwitch])
+		return; // Turn player wins immediately
+
+	auto moveItr = MoveIterator(validMoves);
+	while (BoardMask move = moveItr.GetNext()) {
+		BoardState nextBoard = board;
+		nextBoard.FillMove(move);
+		ForEachSplitPosition(nextBoard, splitPly, visited, fn);
+	}
+}
+
+void Distributed::Coordinate(const fs::path& jobDir, const std::string& rootMoves, int splitPly) {
+	LOG("Coordinating job at \"" << jobDir.string() << "\" (root: \"" << rootMoves << "\", split ply: " << splitPly << ")...");
+
+	for (const char* subDir : { "pending", "claimed", "done" })
+		fs::create_directories(jobDir / subDir);
+
+	JobRoot root = { rootMoves, splitPly };
+	BoardState rootBoard = root.MakeBoard();
+	RASSERT(splitPly > rootBoard.moveCount && splitPly < BOARD_CELL_COUNT, "Bad split ply " << splitPly);
+
+	if (fs::exists(jobDir / "root.txt")) {
+		// Units of two different jobs can't be told apart
+		JobRoot prevRoot = JobRoot::Read(jobDir);
+		if (prevRoot.moves != root.moves || prevRoot.splitPly != root.splitPly) {
+			WARN(
+				"\"" << jobDir.string() << "\" already holds a job with root \"" << prevRoot.moves << "\" and split ply " << prevRoot.splitPly <<
+				", use a new directory"
+			);
+			return;
+		}
+	} else {
+		WriteFileAtomic(jobDir / "root.txt", STR(root.moves << std::endl << root.splitPly << std::endl));
+	}
+
+	// Units being solved right now, "<key>.<worker>.unit" -> "<key>"
+	std::unordered_set<std::string> claimedNames;
+	for (auto& dirEntry : fs::directory_iterator(jobDir / "claimed")) {
+		std::string name = dirEntry.path().filename().string();
+		claimedNames.insert(name.substr(0, name.find('.')));
+	}
+
+	int numWritten = 0, numSkipped = 0, numClaimed = 0;
+	std::unordered_set<uint64_t> visited;
+	ForEachSplitPosition(rootBoard, splitPly, visited,
+		[&](const BoardState& board) {
+			std::string name = KeyToStr(board.GetCanonicalKey());
+			if (fs::exists(jobDir / "done" / (name + ".result"))) {
+				// Solved by a previous run
+				numSkipped++;
+				return;
+			}
+
+			if (claimedNames.count(name)) {
+				// Requeue() puts it back if its worker dies
+				numClaimed++;
+				return;
+			}
+
+			std::ofstream(jobDir / "pending" / (name + ".unit"));
+			numWritten++;
+		}
+	);
+
+	LOG(" > Wrote " << numWritten << " units (" << numSkipped << " already solved, " << numClaimed << " being solved)");
+}
+
+int Distributed::RunWorker(const fs::path& jobDir, TranspositionTable* table) {
+	std::string workerName = KeyToStr(std::random_device()() ^ ((uint64_t)std::random_device()() << 32));
+	LOG("Running worker " << workerName << " on \"" << jobDir.string() << "\"...");
+
+	int numSolved = 0;
+	while (true) {
+		// Find and claim a unit
+		fs::path claimPath = {};
+		uint64_t key = 0;
+		for (auto& dirEntry : fs::directory_iterator(jobDir / "pending")) {
+			std::string name = dirEntry.path().stem().string();
+			fs::path targetPath = jobDir / "claimed" / (name + "." + workerName + ".unit");
+
+			std::error_code error;
+			fs::rename(dirEntry.path(), targetPath, error);
+			if (!error) {
+				// Claimed
+				claimPath = targetPath;
+				key = StrToKey(name);
+				break;
+			}
+		}
+
+		if (claimPath.empty())
+			break; // Nothing left to claim
+
+		BoardState board;
+		RASSERT(BoardState::FromKey(key, board), "Bad unit key " << KeyToStr(key));
+
+		// Keep our claim alive while solving
+		Timer heartbeatTimer = {};
+		SearchInfo searchInfo = {};
+		searchInfo.stopCheck = [&]() -> bool {
+			if (heartbeatTimer.Elapsed() > CLAIM_HEARTBEAT_INTERVAL) {
+				std::error_code error;
+				fs::last_write_time(claimPath, fs::file_time_type::clock::now(), error);
+				heartbeatTimer.Reset();
+			}
+			return false;
+		};
+
+		Timer timer = {};
+		Value eval = Search::AlphaBetaSearch(table, board, searchInfo);
+
+		std::string name = KeyToStr(key);
+		WriteFileAtomic(
+			jobDir / "done" / (name + ".result"),
+			STR((int)eval.val << " " << (int)eval.depth << " " << searchInfo.totalSearched << std::endl)
+		);
+
+		std::error_code error;
+		fs::remove(claimPath, error);
+
+		numSolved++;
+		LOG(" > Solved " << name << ": " << eval << " (searched: " << Util::NumToStr(searchInfo.totalSearched) << ", time: " << timer.Elapsed() << "s)");
+	}
+
+	LOG(" > Worker done, solved " << numSolved << " units");
+	return numSolved;
+}
+
+int Distributed::Requeue(const fs::path& jobDir, double maxClaimAge) {
+	int numRequeued = 0;
+	auto now = fs::file_time_type::clock::now();
+	for (auto& dirEntry : fs::directory_iterator(jobDir / "claimed")) {
+		std::chrono::duration<double> age = now - fs::last_write_time(dirEntry.path());
+		if (age.count() < maxClaimAge)
+			continue;
+
+		// "<key>.<worker>.unit" -> "<key>"
+		std::string name = dirEntry.path().filename().string();
+		name = name.substr(0, name.find('.'));
+
+		std::error_code error;
+		fs::rename(dirEntry.path(), jobDir / "pending" / (name + ".unit"), error);
+		if (!error)
+			numRequeued++;
+	}
+
+	LOG("Requeued " << numRequeued << " units");
+	return numRequeued;
+}
+
+// Results and interior nodes are looked up by canonical key
+static Value MergeRecursive(const BoardState& board, int splitPly, std::unordered_map<uint64_t, Value>& results, BoardMask* outBestMove) {
+	uint64_t key = board.GetCanonicalKey();
+	if (!outBestMove) {
+		auto itr = results.find(key);
+		if (itr != results.end())
+			return itr->second;
+	}
+
+	if (board.moveCount >= splitPly)
+		ERR_CLOSE("Unit " << KeyToStr(key) << " is not solved yet");
+
+	BoardMask validMoves = board.GetValidMoveMask();
+	BoardMask winMoves = validMoves & board.winMasks[board.turnSwitch];
+	if (winMoves) {
+		if (outBestMove)
+			*outBestMove = MoveIterator(winMoves).GetNext();
+		return Value(1, 1);
+	}
+
+	Value bestEval = VALUE_INVALID;
+	auto moveItr = MoveIterator(validMoves);
+	while (BoardMask move = moveItr.GetNext()) {
+		BoardState nextBoard = board;
+		nextBoard.FillMove(move);
+
+		Value nextEval = -MergeRecursive(nextBoard, splitPly, results, NULL);
+		nextEval.depth++;
+
+		if (bestEval == VALUE_INVALID || nextEval > bestEval) {
+			bestEval = nextEval;
+			if (outBestMove)
+				*outBestMove = move;
+		}
+	}
+
+	results[key] = bestEval;
+	return bestEval;
+}
+
+SearchResult Distributed::Merge(const fs::path& jobDir, bool log) {
+	JobRoot root = JobRoot::Read(jobDir);
+	BoardState rootBoard = root.MakeBoard();
+
+	std::unordered_map<uint64_t, Value> results;
+	uint64_t totalSearched = 0;
+	for (auto& dirEntry : fs::directory_iterator(jobDir / "done")) {
+		if (dirEntry.path().extension() != ".result")
+			continue;
+
+		std::ifstream stream = std::ifstream(dirEntry.path());
+		int val, depth;
+		uint64_t searched = 0;
+		stream >> val >> depth >> searched;
+		if (!stream)
+			ERR_CLOSE("Bad result file \"" << dirEntry.path() << "\"");
+
+		results[StrToKey(dirEntry.path().stem().string())] = Value(val, depth);
+		totalSearched += searched;
+	}
+
+	BoardMask bestMove = 0;
+	Value eval = MergeRecursive(rootBoard, root.splitPly, results, &bestMove);
+
+	if (log) {
+		LOG("Merged job \"" << jobDir.string() << "\"");
+		LOG(" > Eval: " << eval << ", best move: " << (Util::BitMaskToIndex(bestMove) / 8 + 1) << ", total searched: " << Util::NumToStr(totalSearched));
+	}
+
+	WriteFileAtomic(jobDir / "result.txt", STR((int)eval.val << " " << (int)eval.depth << " " << (Util::BitMaskToIndex(bestMove) / 8 + 1) << std::endl));
+	return { bestMove, eval, totalSearched };
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Search.h"
+
+// Multi-process solving through a job directory on a (possibly shared) filesystem
+//
+// Layout of the job directory:
+//	root.txt					Root moves and split ply
+//	pending/<key>.unit			Unsolved work units, keyed by canonical position
+//	claimed/<key>.<worker>.unit	Units being solved, claimed by atomically renaming from pending/
+//	done/<key>.result			Solved units
+namespace Distributed {
+	// Claims not touched for this long are assumed to belong to dead workers
+	constexpr double DEFAULT_MAX_CLAIM_AGE = 10 * 60;
+
+	// How often workers touch their claim while solving
+	constexpr double CLAIM_HEARTBEAT_INTERVAL = 30;
+
+	// Writes a work unit for every unique position at splitPly below the root that isn't solved or claimed yet
+	// Can be re-run on the same job, but refuses a job directory holding a different root or split ply
+	void Coordinate(const std::filesystem::path& jobDir, const std::string& rootMoves, int splitPly);
+
+	// Claims and solves units until there are none left, returns the number solved
+	int RunWorker(const std::filesystem::path& jobDir, TranspositionTable* table);
+
+	// Moves claims of dead workers back to pending, returns the number requeued
+	int Requeue(const std::filesystem::path& jobDir, double maxClaimAge = DEFAULT_MAX_CLAIM_AGE);
+
+	// Backs the solved units up to the root with minimax
+	// Fails if any unit is unsolved
+	SearchResult Merge(const std::filesystem::path& jobDir, bool log);
+}
\ No newline at end of file
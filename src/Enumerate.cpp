@@ -0,0 +1,357 @@
+#include "Enumerate.h"
+#include "Eval.h"
+#include "Batch.h"
+#include "Timer.h"
+
+std::filesystem::path Enumerate::GetPlyPath(const std::filesystem::path& dir, int ply) {
+	return dir / STR("ply_" << ply << ".pos");
+}
+
+static std::filesystem::path GetRunPath(const std::filesystem::path& dir, int runIndex) {
+	return dir / STR("run_" << runIndex << ".tmp");
+}
+
+// Always in canonical orientation, so a position and its mirror image sort and deduplicate as one
+static uint64_t PackCanonical(const BoardState& board) {
+	return PackedPosition::Pack(board, true) & ~PackedPosition::MIRRORED_BIT;
+}
+
+static bool IsSymmetrical(uint64_t packed) {
+	uint64_t key = packed & PackedPosition::KEY_MASK;
+	return BoardMask(key).FlipX() == key;
+}
+
+static bool WriteRun(const std::filesystem::path& path, std::vector<uint64_t>& chunk) {
+	std::sort(chunk.begin(), chunk.end());
+	chunk.erase(std::unique(chunk.begin(), chunk.end()), chunk.end());
+
+	PositionFile::Writer writer = PositionFile::Writer(path);
+	for (uint64_t packed : chunk)
+		writer.Write(packed);
+	return writer.Close();
+}
+
+// Expands every position of the previous ply into sorted, deduplicated run files
+static bool ExpandToRuns(const std::filesystem::path& dir, int ply, const Enumerate::Config& config, int& outNumRuns) {
+	PositionFile::Reader reader = PositionFile::Reader(Enumerate::GetPlyPath(dir, ply - 1));
+	if (!reader.IsOpen())
+		return false;
+
+	std::mutex readerMutex;
+	std::atomic<int> nextRunIndex = 0;
+	std::atomic<bool> failed = false;
+
+	size_t chunkSize = MAX(config.memoryMBs * 1024 * 1024 / sizeof(uint64_t) / config.numThreads, (size_t)BOARD_SIZE_X);
+
+	auto fnWork = [&]() {
+		std::vector<uint64_t> block, chunk;
+		chunk.reserve(chunkSize);
+
+		auto fnFlush = [&]() {
+			if (chunk.empty())
+				return;
+
+			if (!WriteRun(GetRunPath(dir, nextRunIndex++), chunk))
+				failed = true;
+			chunk.clear();
+		};
+
+		while (!failed) {
+			{
+				std::lock_guard<std::mutex> lock(readerMutex);
+				if (!reader.ReadBlock(block))
+					break;
+			}
+
+			for (uint64_t packed : block) {
+				BoardState board;
+				PackedPosition::Unpack(packed, board);
+				if (Eval::IsWonAfterMove(board))
+					continue; // The game is over
+
+				if (chunk.size() + BOARD_SIZE_X > chunkSize)
+					fnFlush();
+
+				auto moveItr = MoveIterator(board.GetValidMoveMask());
+				while (BoardMask move = moveItr.GetNext()) {
+					BoardState nextBoard = board;
+					nextBoard.FillMove(move);
+					chunk.push_back(PackCanonical(nextBoard));
+				}
+			}
+		}
+
+		fnFlush();
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < config.numThreads; i++)
+		threads.push_back(std::thread(fnWork));
+	fnWork();
+	for (auto& thread : threads)
+		thread.join();
+
+	outNumRuns = nextRunIndex;
+	return !failed && !reader.failed;
+}
+
+// Runs merged at once at most, also keeps the open files well under the usual descriptor limit
+constexpr int MAX_MERGE_FAN_IN = 256;
+
+// K-way merges sorted position files into one, dropping duplicates across them
+static bool MergeFiles(const std::vector<std::filesystem::path>& inPaths, const std::filesystem::path& outPath, uint64_t& outCount, uint64_t& outFullCount) {
+	struct RunCursor {
+		std::unique_ptr<PositionFile::Reader> reader;
+		std::vector<uint64_t> block;
+		size_t index = 0;
+	};
+
+	std::vector<RunCursor> cursors = std::vector<RunCursor>(inPaths.size());
+
+	// Min-heap of (position, input)
+	typedef std::pair<uint64_t, int> HeapItem;
+	std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<HeapItem>> heap;
+
+	for (int i = 0; i < (int)inPaths.size(); i++) {
+		cursors[i].reader = std::make_unique<PositionFile::Reader>(inPaths[i]);
+		if (cursors[i].reader->ReadBlock(cursors[i].block))
+			heap.push({ cursors[i].block[0], i });
+	}
+
+	bool success = true;
+	PositionFile::Writer writer = PositionFile::Writer(outPath);
+
+	outCount = 0;
+	outFullCount = 0;
+	uint64_t lastPacked = 0;
+	while (!heap.empty()) {
+		auto [packed, inIndex] = heap.top();
+		heap.pop();
+
+		if (outCount == 0 || packed != lastPacked) {
+			writer.Write(packed);
+			outCount++;
+			outFullCount += IsSymmetrical(packed) ? 1 : 2;
+			lastPacked = packed;
+		}
+
+		RunCursor& cursor = cursors[inIndex];
+		cursor.index++;
+		if (cursor.index == cursor.block.size()) {
+			cursor.index = 0;
+			if (!cursor.reader->ReadBlock(cursor.block))
+				continue;
+		}
+		heap.push({ cursor.block[cursor.index], inIndex });
+	}
+
+	for (auto& cursor : cursors)
+		success &= !cursor.reader->failed;
+	success &= writer.Close();
+	return success;
+}
+
+// Merges the run files into the ply's file, in several passes if there are more runs than fit in memory at once
+// Each open run holds a block of positions, as does the output
+static bool MergeRuns(const std::filesystem::path& dir, int ply, int numRuns, const Enumerate::Config& config, uint64_t& outCount, uint64_t& outFullCount, int& outNumPasses) {
+	size_t blockBytes = PositionFile::BLOCK_SIZE * sizeof(uint64_t);
+	int fanIn = (int)CLAMP(config.memoryMBs * 1024 * 1024 / blockBytes - 1, (size_t)2, (size_t)MAX_MERGE_FAN_IN);
+
+	std::error_code error;
+	auto fnGetPaths = [&](const std::vector<int>& runIndices) {
+		std::vector<std::filesystem::path> paths;
+		for (int runIndex : runIndices)
+			paths.push_back(GetRunPath(dir, runIndex));
+		return paths;
+	};
+
+	std::vector<int> runs = std::vector<int>(numRuns);
+	std::iota(runs.begin(), runs.end(), 0);
+	int nextRunIndex = numRuns;
+
+	outNumPasses = 1;
+	while ((int)runs.size() > fanIn) {
+		std::vector<int> mergedRuns;
+		for (size_t start = 0; start < runs.size(); start += fanIn) {
+			std::vector<int> group = std::vector<int>(runs.begin() + start, runs.begin() + MIN(start + fanIn, runs.size()));
+			if (group.size() == 1) {
+				mergedRuns.push_back(group[0]);
+				continue;
+			}
+
+			int mergedRun = nextRunIndex++;
+			uint64_t count, fullCount;
+			if (!MergeFiles(fnGetPaths(group), GetRunPath(dir, mergedRun), count, fullCount))
+				return false;
+
+			for (int runIndex : group)
+				std::filesystem::remove(GetRunPath(dir, runIndex), error);
+			mergedRuns.push_back(mergedRun);
+		}
+
+		runs = mergedRuns;
+		outNumPasses++;
+	}
+
+	std::filesystem::path plyPath = Enumerate::GetPlyPath(dir, ply);
+	std::filesystem::path tempPath = plyPath;
+	tempPath += ".tmp";
+
+	if (!MergeFiles(fnGetPaths(runs), tempPath, outCount, outFullCount))
+		return false;
+
+	std::filesystem::rename(tempPath, plyPath, error);
+	if (error)
+		return false;
+
+	for (int runIndex : runs)
+		std::filesystem::remove(GetRunPath(dir, runIndex), error);
+	return true;
+}
+
+// Positions decoded at once, so win masks and valid moves go through the batched kernels
+constexpr size_t EXPAND_BATCH_SIZE = 1024;
+
+// Canonical key of the position after the turn player moves, from the position's masks
+static uint64_t GetChildCanonicalKey(BoardMask oppMask, BoardMask combinedMask, BoardMask move) {
+	// The opponent is the turn player of the child
+	BoardMask childCombined = combinedMask | move;
+	uint64_t key = oppMask + childCombined + BoardMask::GetBottomMask();
+	uint64_t mirroredKey = oppMask.FlipX() + childCombined.FlipX() + BoardMask::GetBottomMask();
+	return MIN(key, mirroredKey);
+}
+
+std::vector<uint64_t> Enumerate::ExpandKeys(const std::vector<uint64_t>& keys, int numThreads) {
+	std::vector<std::vector<uint64_t>> threadChildren = std::vector<std::vector<uint64_t>>(numThreads);
+
+	auto fnWork = [&](int threadIndex) {
+		std::vector<uint64_t>& children = threadChildren[threadIndex];
+		std::vector<uint64_t> selfMasks(EXPAND_BATCH_SIZE), oppMasks(EXPAND_BATCH_SIZE), combinedMasks(EXPAND_BATCH_SIZE);
+		std::vector<uint64_t> selfWinMasks(EXPAND_BATCH_SIZE), validMoves(EXPAND_BATCH_SIZE);
+
+		// Every numThreads-th key, a batch at a time
+		for (size_t start = threadIndex; start < keys.size(); start += EXPAND_BATCH_SIZE * numThreads) {
+			size_t count = 0;
+			for (size_t i = start; i < keys.size() && count < EXPAND_BATCH_SIZE; i += numThreads, count++) {
+				BoardMask selfMask, combinedMask;
+				BoardState::DecodeKey(keys[i], selfMask, combinedMask);
+				selfMasks[count] = selfMask;
+				oppMasks[count] = combinedMask & ~selfMask;
+				combinedMasks[count] = combinedMask;
+			}
+
+			Batch::MakeWinMasks(selfMasks.data(), selfWinMasks.data(), count);
+			Batch::GetValidMoveMasks(combinedMasks.data(), validMoves.data(), count);
+
+			for (size_t i = 0; i < count; i++) {
+				// Winning moves end the game, so their positions are never searched
+				auto moveItr = MoveIterator(validMoves[i] & ~selfWinMasks[i]);
+				while (BoardMask move = moveItr.GetNext())
+					children.push_back(GetChildCanonicalKey(oppMasks[i], combinedMasks[i], move));
+			}
+		}
+
+		std::sort(children.begin(), children.end());
+		children.erase(std::unique(children.begin(), children.end()), children.end());
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < numThreads; i++)
+		threads.push_back(std::thread(fnWork, i));
+	fnWork(0);
+	for (auto& thread : threads)
+		thread.join();
+
+	std::vector<uint64_t> result;
+	for (auto& children : threadChildren)
+		result.insert(result.end(), children.begin(), children.end());
+
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+	return result;
+}
+
+bool Enumerate::Run(const std::filesystem::path& dir, int maxPly, const Config& config) {
+	RASSERT(maxPly >= 0 && maxPly <= BOARD_CELL_COUNT, "Bad ply: " << maxPly);
+	RASSERT(config.numThreads >= 1, "Bad thread count: " << config.numThreads);
+
+	std::error_code error;
+	std::filesystem::create_directories(dir, error);
+
+	LOG("Enumerating positions up to ply " << maxPly << " in \"" << dir.string() << "\" (threads: " << config.numThreads << ", memory: " << config.memoryMBs << "MB)...");
+
+	if (!std::filesystem::exists(GetPlyPath(dir, 0))) {
+		PositionFile::Writer writer = PositionFile::Writer(GetPlyPath(dir, 0));
+		writer.Write(PackCanonical(BoardState()));
+		if (!writer.Close())
+			return false;
+	}
+
+	for (int ply = 1; ply <= maxPly; ply++) {
+		if (std::filesystem::exists(GetPlyPath(dir, ply))) {
+			LOG(" > Ply " << ply << " already complete");
+			continue;
+		}
+
+		// Leftovers of an interrupted run
+		for (auto& dirEntry : std::filesystem::directory_iterator(dir))
+			if (dirEntry.path().extension() == ".tmp")
+				std::filesystem::remove(dirEntry.path(), error);
+
+		Timer timer = {};
+		int numRuns = 0;
+		if (!ExpandToRuns(dir, ply, config, numRuns)) {
+			WARN("Failed to expand ply " << ply);
+			return false;
+		}
+
+		uint64_t count, fullCount;
+		int numPasses;
+		if (!MergeRuns(dir, ply, numRuns, config, count, fullCount, numPasses)) {
+			WARN("Failed to merge ply " << ply);
+			return false;
+		}
+
+		LOG(" > Ply " << ply << ": " << count << " positions (" << fullCount << " counting mirror images), runs: " << numRuns << ", merge passes: " << numPasses << ", time: " << timer.Elapsed() << "s");
+	}
+
+	return true;
+}
+
+// Whether the target is reached by stacking its remaining stones on the board in some order
+// The target fixes the color of every stone, so a state is just the cells filled so far
+static bool IsReachable(const BoardState& board, const BoardState& target, std::unordered_set<uint64_t>& visited) {
+	if (board.moveCount == target.moveCount)
+		return board.GetCombinedMask() == target.GetCombinedMask();
+
+	if (!visited.insert(board.GetCombinedMask()).second)
+		return false;
+
+	auto moveItr = MoveIterator(board.GetValidMoveMask() & target.teams[board.turnSwitch]);
+	while (BoardMask move = moveItr.GetNext()) {
+		BoardState nextBoard = board;
+		nextBoard.FillMove(move);
+		if (IsReachable(nextBoard, target, visited))
+			return true;
+	}
+
+	return false;
+}
+
+bool Enumerate::IsInSubtree(const BoardState& root, const BoardState& board) {
+	if (board.moveCount < root.moveCount)
+		return false;
+
+	// Keys are canonical, so either orientation of the root has the same subtree
+	for (bool mirrored : { false, true }) {
+		BoardState start = mirrored ? BoardState(root.teams[0].FlipX(), root.teams[1].FlipX()) : root;
+		if ((start.teams[0] & ~board.teams[0]) || (start.teams[1] & ~board.teams[1]))
+			continue;
+
+		std::unordered_set<uint64_t> visited;
+		if (IsReachable(start, board, visited))
+			return true;
+	}
+
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "PositionFile.h"
+
+// Breadth-first enumeration of every distinct position (modulo mirror symmetry) ply by ply, in bounded memory
+// Each ply is expanded from the previous ply's file: children are gathered into per-thread chunks,
+// each chunk is sorted and deduplicated into a run file, then the runs are merged into the ply's file
+// (in several passes if there are too many runs to merge at once within the memory budget)
+//
+// Layout of the output directory:
+//	ply_<n>.pos		Sorted canonical positions at ply n (PositionFile), only present once complete
+//	run_<i>.tmp		Sorted chunks of the ply being built
+//
+// Positions where the game was won are included, but not expanded
+// Re-running with the same directory continues after the last complete ply
+namespace Enumerate {
+	constexpr size_t DEFAULT_MEMORY_MBS = 1024;
+
+	struct Config {
+		int numThreads = 1;
+		size_t memoryMBs = DEFAULT_MEMORY_MBS; // Split between the threads' chunks, and bounds the runs merged at once
+	};
+
+	std::filesystem::path GetPlyPath(const std::filesystem::path& dir, int ply);
+
+	// Returns false if anything failed, already complete plies are kept
+	bool Run(const std::filesystem::path& dir, int maxPly, const Config& config);
+
+	// In-memory expansion for small subtrees: the sorted unique canonical keys of the children of every position
+	// Winning moves are skipped, so every child is a position where the game goes on
+	std::vector<uint64_t> ExpandKeys(const std::vector<uint64_t>& keys, int numThreads);
+
+	// Whether the board is reachable from the root or its mirror image, so it's among the positions expanded from the root's canonical key
+	// (Used to guard files that store values without their keys)
+	bool IsInSubtree(const BoardState& root, const BoardState& board);
+}
\ No newline at end of file
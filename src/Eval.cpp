@@ -22,8 +22,9 @@ constexpr int MAX_WINS_PER_POS = CONNECT_WIN_AMOUNT * 4;
 static BoardMask g_WinStatesForPos[BOARD_SIZE_X][BOARD_SIZE_Y][MAX_WINS_PER_POS];
 static BoardMask g_WinStates[NUM_WINNING_STATES];
 
-void Eval::Init() {
-	LOG("Initializing eval...");
+void Eval::Init(bool log) {
+	if (log)
+		LOG("Initializing eval...");
 
 	//////////////////
 
@@ -58,7 +59,8 @@ void Eval::Init() {
 		}
 	}
 
-	LOG(" > Found " << winStates.size() << " winning states (h: " << numHorizotal << ", v: " << numVertical << ", d: " << numDiagonal << ")");
+	if (log)
+		LOG(" > Found " << winStates.size() << " winning states (h: " << numHorizotal << ", v: " << numVertical << ", d: " << numDiagonal << ")");
 
 	RASSERT(numHorizotal == (BOARD_SIZE_X - CONNECT_START_MARGIN) * BOARD_SIZE_Y, "Bad horizontal win generation");
 	RASSERT(numVertical == BOARD_SIZE_X * (BOARD_SIZE_Y - CONNECT_START_MARGIN), "Bad vertical win generation");
@@ -85,7 +87,8 @@ void Eval::Init() {
 		}
 	}
 
-	LOG(" > Generated per-pos win states");
+	if (log)
+		LOG(" > Generated per-pos win states");
 }
 
 bool Eval::IsWonAfterMove(const BoardState& board) {
@@ -182,36 +185,35 @@ float Eval::EvalBoard(const BoardState& board) {
 	return rating;
 }
 
-float RateBoardTeam(BoardMask hbSelf, BoardMask hbOpp, int teamIdx) {
+// Rates the threats the turn player has after a move
+static float RateThreats(BoardMask threatsMask, const Eval::MoveWeights& weights) {
 	float rating = 0;
 
-	BoardMask threatsMask = hbSelf.MakeWinMask() & ~hbOpp;
 	int numThreats = Util::BitCount64(threatsMask);
-	rating += numThreats * 512;
+	rating += numThreats * weights.threat;
 
 	// Gaining an odd-row threat is generally advantageous
 	if (threatsMask & BoardMask::GetParityRows(true))
-		rating += 256;
+		rating += weights.oddThreat;
 
 	// Stacked threats are super powerful
 	BoardMask stackedThreatsMask = (threatsMask >> 1) & threatsMask;
 	int numStackedThreats = Util::BitCount64(stackedThreatsMask);
-	rating += 4096 * numStackedThreats;
+	rating += weights.stackedThreat * numStackedThreats;
 
 	return rating;
 }
 
-float RateBoard(const BoardState& board, BoardMask moveMask) {
-	return RateBoardTeam(board.teams[board.turnSwitch] | moveMask, board.teams[!board.turnSwitch], board.turnSwitch);
+float Eval::RateMove(const BoardState& board, BoardMask moveMask, const MoveWeights& weights) {
+	BoardMask nextWinMask = BoardMask::MakeWinMask(board.teams[board.turnSwitch] | moveMask) & ~board.teams[!board.turnSwitch];
+	return RateMove(board, moveMask, nextWinMask, weights);
 }
 
-float Eval::RateMove(const BoardState& board, BoardMask moveMask) {
+float Eval::RateMove(const BoardState& board, BoardMask moveMask, BoardMask nextWinMask, const MoveWeights& weights) {
 
-	auto hbSelf = board.teams[board.turnSwitch];
-	auto hbOpp = board.teams[!board.turnSwitch];
 	auto hbSelfWin = board.winMasks[board.turnSwitch];
 
-	float nextBoardRating = RateBoard(board, moveMask);
+	float nextBoardRating = RateThreats(nextWinMask, weights);
 
 	constexpr auto fnBumpMask = [](BoardMask hb, BoardMask move, int shift) -> BoardMask {
 		return move & (((shift > 0) ? (hb << shift) : (hb >> -shift)) & BoardMask::GetBoardMask());
@@ -234,9 +236,9 @@ float Eval::RateMove(const BoardState& board, BoardMask moveMask) {
 
 	return
 		nextBoardRating
-		+ belowOurWin2 * 1024 // Creating a zungzwang threat is very
-		- belowOurWin * 512 // Losing our zungzwang is bad
-		+ closesColumn * 512 // Closing columns is usually good as it gives zungzwang back to the opponent
-		+ -offCenterAmountX // Last priority is being centered
+		+ belowOurWin2 * weights.makeZugzwang // Creating a zungzwang threat is very
+		- belowOurWin * weights.loseZugzwang // Losing our zungzwang is bad
+		+ closesColumn * weights.closeColumn // Closing columns is usually good as it gives zungzwang back to the opponent
+		+ -offCenterAmountX * weights.offCenter // Last priority is being centered
 		;
 }
\ No newline at end of file
@@ -55,12 +55,48 @@ struct Value {
 constexpr Value VALUE_INVALID = INT8_MIN;
 
 namespace Eval {
-	void Init();
+	// Move ordering weights of RateMove(), set at runtime to compare and tune engine variants (see Match.h)
+	struct MoveWeights {
+		float threat = 512; // Per threat after the move
+		float oddThreat = 256; // Having any odd-row threat
+		float stackedThreat = 4096; // Per threat directly above another
+		float makeZugzwang = 1024; // Playing two below our threat
+		float loseZugzwang = 512; // Playing right below our threat
+		float closeColumn = 512;
+		float offCenter = 1; // Per half column from the center
+	};
+
+	constexpr MoveWeights DEFAULT_MOVE_WEIGHTS = {};
+
+	// Every weight by name, for parsing and printing them
+	struct MoveWeightField {
+		const char* name; // Option key
+		const char* memberName;
+		float MoveWeights::* member;
+	};
+
+	constexpr MoveWeightField MOVE_WEIGHT_FIELDS[] = {
+		{ "threat", "threat", &MoveWeights::threat },
+		{ "oddthreat", "oddThreat", &MoveWeights::oddThreat },
+		{ "stackedthreat", "stackedThreat", &MoveWeights::stackedThreat },
+		{ "makezugzwang", "makeZugzwang", &MoveWeights::makeZugzwang },
+		{ "losezugzwang", "loseZugzwang", &MoveWeights::loseZugzwang },
+		{ "closecolumn", "closeColumn", &MoveWeights::closeColumn },
+		{ "offcenter", "offCenter", &MoveWeights::offCenter },
+	};
+
+	constexpr int NUM_MOVE_WEIGHTS = sizeof(MOVE_WEIGHT_FIELDS) / sizeof(MOVE_WEIGHT_FIELDS[0]);
+	static_assert(sizeof(MoveWeights) == NUM_MOVE_WEIGHTS * sizeof(float), "Every weight needs a field entry");
+
+	void Init(bool log = true);
 	bool IsWonAfterMove(const BoardState& board);
 
 	// Returns the eval if win/loss/draw, else returns VALUE_INVALID 
 	// Modifies validMovesMask if moves are forced
 	Value EvalAndCropValidMoves(const BoardState& board, BoardMask& validMovesMask);
 	float EvalBoard(const BoardState& board);
-	float RateMove(const BoardState& board, BoardMask moveMask);
+	float RateMove(const BoardState& board, BoardMask moveMask, const MoveWeights& weights = DEFAULT_MOVE_WEIGHTS);
+
+	// Same as RateMove(), with the turn player's win mask after the move already made
+	float RateMove(const BoardState& board, BoardMask moveMask, BoardMask nextWinMask, const MoveWeights& weights = DEFAULT_MOVE_WEIGHTS);
 }
\ No newline at end of file
@@ -23,12 +23,17 @@
 #include <filesystem>
 #include <random>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <bit>
 #include <thread>
+#include <memory>
 #include <cstring>
 #include <array>
 #include <bitset>
 #include <numeric>
+#include <climits>
+#include <cfloat>
 
 #ifdef _MSC_VER
 // Disable annoying truncation warnings on MSVC
@@ -195,14 +195,15 @@ bool CheckClaimEven(const BoardState& board, InstaSolver::Result& outResult) {
 	return true;
 }
 
-InstaSolver::Result InstaSolver::Solve(const BoardState& board) {
+InstaSolver::Result InstaSolver::Solve(const BoardState& board, uint32_t ruleMask) {
 	
-	Result result = { ResultType::NONE, VALUE_INVALID };
+	Result result = { ResultType::NONE, VALUE_INVALID, NUM_RULES };
 
-	if (
-		CheckClaimEven(board, result)
-		|| CheckIsolatedColumns(board, result)
-		) {}
+	if ((ruleMask & (1u << RULE_CLAIM_EVEN)) && CheckClaimEven(board, result)) {
+		result.rule = RULE_CLAIM_EVEN;
+	} else if ((ruleMask & (1u << RULE_ISOLATED_COLUMNS)) && CheckIsolatedColumns(board, result)) {
+		result.rule = RULE_ISOLATED_COLUMNS;
+	}
 
 	return result;
 }
\ No newline at end of file
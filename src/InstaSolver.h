@@ -13,10 +13,24 @@ namespace InstaSolver {
 		EXACT // Guaranteed outcome of the state assuming perfect play
 	};
 
+	// Rules are tried in this order until one finds a solution
+	enum Rule {
+		RULE_CLAIM_EVEN,
+		RULE_ISOLATED_COLUMNS,
+
+		NUM_RULES
+	};
+
+	constexpr const char* RULE_NAMES[NUM_RULES] = { "claimEven", "isolatedColumns" };
+
+	// Bit per rule, rules not in the mask are skipped
+	constexpr uint32_t ALL_RULES = (1u << NUM_RULES) - 1;
+
 	struct Result {
 		ResultType type;
 		Value eval;
+		Rule rule = NUM_RULES; // NUM_RULES if no rule found a solution
 	};
 
-	Result Solve(const BoardState& board);
+	Result Solve(const BoardState& board, uint32_t ruleMask = ALL_RULES);
 }
\ No newline at end of file
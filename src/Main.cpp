@@ -3,40 +3,476 @@
 #include "Framework.h"
 
 #include "Search.h"
+#include "ParallelSearch.h"
+#include "Distributed.h"
+#include "Checkpoint.h"
+#include "Perft.h"
+#include "PositionFile.h"
+#include "Dataset.h"
+#include "Enumerate.h"
+#include "Tablebase.h"
+#include "Book.h"
+#include "ProofSearch.h"
+#include "Ponder.h"
+#include "Match.h"
+#include "Tune.h"
+#include "Numa.h"
 #include "DataStream.h"
 #include "Testing.h"
 
 int main(int argc, char* argv[]) {
 
 	bool doTesting = false;
+	bool doParallelTesting = false;
+	bool doNumaTesting = false;
+	bool doProofTesting = false;
+	bool doBatchTesting = false;
+	bool doApiTesting = false;
+	bool doTablebaseTesting = false;
+	int numThreads = 1;
+	bool pinThreads = false;
+	bool useNearLeaf = false;
+	int nearLeafEmptyCells = DEFAULT_SEARCH_CONFIG.nearLeafEmptyCells;
+	Numa::Placement tablePlacement = Numa::PLACEMENT_DEFAULT;
+
+	// Solving a single position
+	bool doSolve = false;
+	std::string solveMoves = {};
+	std::string checkpointDir = {};
+	bool saveTable = false;
+	std::string tablePath = {};
+	std::string sharedTableName = {};
+	std::string unlinkSharedName = {};
+	std::string statsPath = {};
+
+	// Solving with proof-number search instead, for both goals unless one is given
+	bool useProofSearch = false;
+	std::string proofGoal = {};
+	ProofSearch::Config proofConfig = {};
+
+	// Perft
+	int perftDepth = 0;
+	bool perftSymmetry = false;
+
+	std::string convertInPath = {}, convertOutPath = {};
+
+	std::string datasetPath = {};
+	Dataset::Config datasetConfig = {};
+
+	std::string enumerateDir = {};
+	int enumerateMaxPly = 0;
+	Enumerate::Config enumerateConfig = {};
+
+	// Endgame tablebase
+	std::string buildTablebasePath = {}, tablebasePath = {};
+	Tablebase::BuildConfig tablebaseConfig = {};
+
+	// Opening book
+	std::string buildBookPath = {}, bookPath = {};
+	Book::BuildConfig bookConfig = {};
+
+	// Distributed solving
+	std::string coordinateDir = {}, workerDir = {}, requeueDir = {}, mergeDir = {};
+	int splitPly = 0;
+	std::string rootMoves = {};
+
+	// Engine-versus-engine match
+	bool doMatch = false;
+	std::string matchBaseOptions = {}, matchTestOptions = {}, matchLogPath = {};
+	Match::Config matchConfig = {};
+
+	// Move weight tuning
+	bool doTune = false;
+	Tune::Config tuneConfig = {};
+
+	// Interactive play
+	bool playHuman = false;
+	std::string playMoves = {};
+	bool ponder = true;
 
 	// Parse args
 	for (int i = 1; i < argc; i++) {
 		std::string arg = argv[i];
 		if (arg == "-t")
 			doTesting = true;
+		if (arg == "-tp")
+			doParallelTesting = true;
+		if (arg == "-tn")
+			doNumaTesting = true;
+		if (arg == "-tdfpn")
+			doProofTesting = true;
+		if (arg == "-tbatch")
+			doBatchTesting = true;
+		if (arg == "-tapi")
+			doApiTesting = true;
+		if (arg == "-ttablebase")
+			doTablebaseTesting = true;
+		if (arg == "-threads" && i + 1 < argc)
+			numThreads = std::stoi(argv[++i]);
+		if (arg == "-play") {
+			playHuman = true;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				playMoves = argv[++i];
+		}
+		if (arg == "-noponder")
+			ponder = false;
+		if (arg == "-pin")
+			pinThreads = true;
+		if (arg == "-nearleaf") {
+			useNearLeaf = true;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				nearLeafEmptyCells = std::stoi(argv[++i]);
+		}
+		if (arg == "-numa" && i + 1 < argc) {
+			std::string placementStr = argv[++i];
+			if (placementStr == "interleave") {
+				tablePlacement = Numa::PLACEMENT_INTERLEAVE;
+			} else if (placementStr == "partition") {
+				tablePlacement = Numa::PLACEMENT_PARTITION;
+			} else {
+				ERR_CLOSE("Unknown NUMA placement \"" << placementStr << "\", should be \"interleave\" or \"partition\"");
+			}
+		}
+		if (arg == "-solve") {
+			doSolve = true;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				solveMoves = argv[++i];
+		}
+		if (arg == "-dfpn") {
+			useProofSearch = true;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				proofGoal = argv[++i];
+		}
+		if (arg == "-dfpnnodes" && i + 1 < argc)
+			proofConfig.maxNodes = std::stoull(argv[++i]);
+		if (arg == "-checkpoint" && i + 1 < argc)
+			checkpointDir = argv[++i];
+		if (arg == "-savetable")
+			saveTable = true;
+		if (arg == "-tablefile" && i + 1 < argc)
+			tablePath = argv[++i];
+		if (arg == "-sharedtable" && i + 1 < argc)
+			sharedTableName = argv[++i];
+		if (arg == "-unlinkshared" && i + 1 < argc)
+			unlinkSharedName = argv[++i];
+		if (arg == "-stats" && i + 1 < argc)
+			statsPath = argv[++i];
+		if (arg == "-perft" && i + 1 < argc)
+			perftDepth = std::stoi(argv[++i]);
+		if (arg == "-perftsym")
+			perftSymmetry = true;
+		if (arg == "-dataset" && i + 3 < argc) {
+			datasetPath = argv[++i];
+			datasetConfig.ply = std::stoi(argv[++i]);
+			datasetConfig.numPositions = std::stoull(argv[++i]);
+		}
+		if (arg == "-enumerate" && i + 2 < argc) {
+			enumerateDir = argv[++i];
+			enumerateMaxPly = std::stoi(argv[++i]);
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				enumerateConfig.memoryMBs = std::stoull(argv[++i]);
+		}
+		if (arg == "-buildtablebase" && i + 2 < argc) {
+			buildTablebasePath = argv[++i];
+			tablebaseConfig.maxEmpty = std::stoi(argv[++i]);
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				tablebaseConfig.rootMoves = argv[++i];
+		}
+		if (arg == "-tablebase" && i + 1 < argc)
+			tablebasePath = argv[++i];
+		if (arg == "-buildbook" && i + 2 < argc) {
+			buildBookPath = argv[++i];
+			bookConfig.maxPly = std::stoi(argv[++i]);
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				bookConfig.rootMoves = argv[++i];
+		}
+		if (arg == "-book" && i + 1 < argc)
+			bookPath = argv[++i];
+		if (arg == "-convertpositions" && i + 2 < argc) {
+			convertInPath = argv[++i];
+			convertOutPath = argv[++i];
+		}
+		if (arg == "-match" && i + 2 < argc) {
+			doMatch = true;
+			matchBaseOptions = argv[++i];
+			matchTestOptions = argv[++i];
+		}
+		if (arg == "-matchpairs" && i + 1 < argc)
+			matchConfig.maxPairs = std::stoi(argv[++i]);
+		if (arg == "-matchply" && i + 1 < argc)
+			matchConfig.openingPly = std::stoi(argv[++i]);
+		if (arg == "-matchopenings" && i + 1 < argc)
+			matchConfig.openingsPath = argv[++i];
+		if (arg == "-matchspeedup" && i + 1 < argc)
+			matchConfig.minSpeedup = std::stod(argv[++i]);
+		if (arg == "-matchnodes")
+			matchConfig.metric = Match::METRIC_NODES;
+		if (arg == "-matchlog" && i + 1 < argc)
+			matchLogPath = argv[++i];
+		if (arg == "-tune" && i + 2 < argc) {
+			doTune = true;
+			tuneConfig.corpusPly = std::stoi(argv[++i]);
+			tuneConfig.corpusSize = std::stoi(argv[++i]);
+		}
+		if (arg == "-tunecorpus" && i + 1 < argc)
+			tuneConfig.corpusPath = argv[++i];
+		if (arg == "-coordinate" && i + 2 < argc) {
+			coordinateDir = argv[++i];
+			splitPly = std::stoi(argv[++i]);
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				rootMoves = argv[++i];
+		}
+		if (arg == "-worker" && i + 1 < argc)
+			workerDir = argv[++i];
+		if (arg == "-requeue" && i + 1 < argc)
+			requeueDir = argv[++i];
+		if (arg == "-merge" && i + 1 < argc)
+			mergeDir = argv[++i];
 	}
 
 	Eval::Init();
+	Numa::LogTopology();
+
+	if (!unlinkSharedName.empty()) {
+		if (!SharedMemory::Unlink(unlinkSharedName))
+			WARN("No shared table named \"" << unlinkSharedName << "\"");
+		return EXIT_SUCCESS;
+	}
+
+	if (doBatchTesting) {
+		Testing::TestBatchKernels();
+		return EXIT_SUCCESS;
+	}
+
+	if (!convertInPath.empty())
+		return PositionFile::Convert(convertInPath, convertOutPath) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+	if (!datasetPath.empty()) {
+		datasetConfig.numThreads = numThreads;
+		return Dataset::Generate(datasetPath, datasetConfig) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (doMatch) {
+		if (!Match::ParseEngineConfig(matchBaseOptions, matchConfig.base) || !Match::ParseEngineConfig(matchTestOptions, matchConfig.test))
+			return EXIT_FAILURE;
+
+		matchConfig.numThreads = numThreads;
+		Match::Run(matchConfig, matchLogPath);
+		return EXIT_SUCCESS;
+	}
+
+	if (doTune) {
+		tuneConfig.numThreads = numThreads;
+		Tune::Run(tuneConfig);
+		return EXIT_SUCCESS;
+	}
+
+	if (!enumerateDir.empty()) {
+		enumerateConfig.numThreads = numThreads;
+		return Enumerate::Run(enumerateDir, enumerateMaxPly, enumerateConfig) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (!buildTablebasePath.empty()) {
+		tablebaseConfig.numThreads = numThreads;
+		if (!Tablebase::Build(buildTablebasePath, tablebaseConfig))
+			return EXIT_FAILURE;
+
+		Tablebase builtTablebase = {};
+		if (!builtTablebase.Load(buildTablebasePath))
+			return EXIT_FAILURE;
+
+		LOG(" > Probe latency: " << builtTablebase.MeasureProbeLatency() << "ns");
+		return EXIT_SUCCESS;
+	}
+
+	if (!buildBookPath.empty()) {
+		bookConfig.numThreads = numThreads;
+		if (!Book::Build(buildBookPath, bookConfig))
+			return EXIT_FAILURE;
+
+		Book builtBook = {};
+		if (!builtBook.Load(buildBookPath))
+			return EXIT_FAILURE;
+
+		LOG(" > Probe latency: " << builtBook.MeasureProbeLatency() << "ns");
+		return EXIT_SUCCESS;
+	}
+
+	if (perftDepth > 0) {
+		Perft::Config perftConfig = {};
+		perftConfig.numThreads = numThreads;
+		perftConfig.useSymmetry = perftSymmetry;
+		return Perft::Run(perftDepth, perftConfig) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (!coordinateDir.empty()) {
+		Distributed::Coordinate(coordinateDir, rootMoves, splitPly);
+		return EXIT_SUCCESS;
+	}
+
+	if (!requeueDir.empty()) {
+		Distributed::Requeue(requeueDir);
+		return EXIT_SUCCESS;
+	}
+
+	if (!mergeDir.empty()) {
+		Distributed::Merge(mergeDir, true);
+		return EXIT_SUCCESS;
+	}
 
 	BoardState board = {};
-	bool computerOnly = true;
+	bool computerOnly = !playHuman;
 
 	auto table = new TranspositionTable();
 
+	ParallelSearch::Config parallelConfig = {};
+	parallelConfig.numThreads = numThreads;
+	if (pinThreads)
+		parallelConfig.pinCpus = Numa::GetPinCpus(numThreads, Numa::GetTopology().nodeCpus.size());
+
+	if (!sharedTableName.empty()) {
+		if (table->AttachShared(sharedTableName))
+			LOG("Attached shared table \"" << sharedTableName << "\"");
+	}
+
+	parallelConfig.search.nearLeafEmptyCells = nearLeafEmptyCells;
+	if (useNearLeaf)
+		table->EnableNearLeaf();
+
+	Tablebase tablebase = {};
+	if (!tablebasePath.empty()) {
+		if (tablebase.Load(tablebasePath)) {
+			LOG("Loaded tablebase from \"" << tablebasePath << "\" (max empty cells: " << tablebase.GetMaxEmpty() << ")");
+			parallelConfig.tablebase = &tablebase;
+		}
+	}
+
+	Book book = {};
+	if (!bookPath.empty()) {
+		if (book.Load(bookPath)) {
+			LOG("Loaded book from \"" << bookPath << "\"");
+			parallelConfig.book = &book;
+		}
+	}
+
+	if (!tablePath.empty()) {
+		Timer loadTimer = {};
+		if (table->Load(tablePath))
+			LOG("Loaded table from \"" << tablePath << "\" in " << loadTimer.Elapsed() << "s");
+	}
+
+	// Only once the entries are final, attaching or loading replaces them
+	if (tablePlacement != Numa::PLACEMENT_DEFAULT) {
+		if (!Numa::PlaceMemory(table->entries, table->GetSizeBytes(), tablePlacement, Numa::GetTopology().nodeCpus.size()))
+			WARN("Failed to apply NUMA placement to the table");
+	}
+
 	if (doTesting) {
 		Testing::TestEfficiency(table);
 		Testing::TestMoveEval(table);
 		return EXIT_SUCCESS;
 	}
 
-	std::string movesStr = {};
+	if (!workerDir.empty()) {
+		Distributed::RunWorker(workerDir, table);
+		return EXIT_SUCCESS;
+	}
+
+	if (doSolve) {
+		BoardState solveBoard = {};
+		solveBoard.PlayMoveString(solveMoves);
+		LOG("Solving: " << solveBoard);
+
+		if (useProofSearch) {
+			ProofSearch::Table proofTable = ProofSearch::Table(proofConfig.tableMBs);
+			if (proofGoal.empty()) {
+				ProofSearch::Solve(&proofTable, solveBoard, proofConfig, true);
+				return EXIT_SUCCESS;
+			}
+
+			ProofSearch::Goal goal;
+			if (proofGoal == "win") {
+				goal = ProofSearch::GOAL_WIN;
+			} else if (proofGoal == "draw") {
+				goal = ProofSearch::GOAL_AT_LEAST_DRAW;
+			} else {
+				ERR_CLOSE("Unknown proof goal \"" << proofGoal << "\", should be \"win\" or \"draw\"");
+			}
+
+			Timer proofTimer = {};
+			ProofSearch::Result proofResult = ProofSearch::Prove(&proofTable, solveBoard, goal, proofConfig);
+			constexpr const char* OUTCOME_NAMES[] = { "unknown (node limit)", "proven", "disproven" };
+			LOG(
+				"Goal \"" << proofGoal << "\": " << OUTCOME_NAMES[proofResult.outcome] <<
+				", proof nodes: " << Util::NumToStr(proofResult.nodes) << ", time: " << proofTimer.Elapsed() << "s"
+			);
+			return EXIT_SUCCESS;
+		}
+
+		SearchResult result;
+		if (!checkpointDir.empty()) {
+			if (numThreads > 1)
+				WARN("-checkpoint solves on one thread, ignoring -threads " << numThreads);
+			result = Checkpoint::Search(table, solveBoard, checkpointDir, saveTable, true, parallelConfig.tablebase, parallelConfig.book, parallelConfig.search);
+		} else if (numThreads > 1) {
+			result = ParallelSearch::Search(table, solveBoard, parallelConfig, true);
+		} else {
+			result = Search::Search(table, solveBoard, true, parallelConfig.tablebase, parallelConfig.book, {}, parallelConfig.search);
+		}
+
+		if (!statsPath.empty()) {
+#if SEARCH_STATS
+			if (result.stats.WriteJSON(statsPath)) {
+				LOG("Wrote search stats to \"" << statsPath << "\"");
+			} else {
+				WARN("Failed to write search stats to \"" << statsPath << "\"");
+			}
+#else
+			WARN("Search stats are compiled out (SEARCH_STATS is 0)");
+#endif
+		}
+
+		if (!tablePath.empty())
+			table->Save(tablePath);
+		return EXIT_SUCCESS;
+	}
+
+	if (doProofTesting) {
+		Testing::TestProofSearch(table);
+		return EXIT_SUCCESS;
+	}
+
+	if (doApiTesting) {
+		Testing::TestApi(table);
+		return EXIT_SUCCESS;
+	}
+
+	if (doTablebaseTesting) {
+		Testing::TestTablebase(table);
+		return EXIT_SUCCESS;
+	}
+
+	if (doNumaTesting) {
+		Testing::TestNuma(table);
+		return EXIT_SUCCESS;
+	}
+
+	if (doParallelTesting) {
+		Testing::TestParallelScaling(table);
+		return EXIT_SUCCESS;
+	}
+
+	// The human plays the side to move after the starting moves
+	board.PlayMoveString(playMoves);
+	bool humanTurnSwitch = board.turnSwitch;
+
+	std::string movesStr = playMoves;
 	while (true) {
 		LOG("Board: " << board);
 		if (!movesStr.empty())
 			LOG("(Moves: " << movesStr << ")");
 
-		bool humansTurn = !board.turnSwitch && !computerOnly;
+		bool humansTurn = (board.turnSwitch == humanTurnSwitch) && !computerOnly;
 
 		if (Eval::IsWonAfterMove(board)) {
 			const char* winner;
@@ -60,17 +496,26 @@ int main(int argc, char* argv[]) {
 
 		int chosenMoveIndex;
 		if (!humansTurn) {
-			auto searchResult = Search::Search(table, board, true);
+			SearchResult searchResult;
+			if (numThreads > 1) {
+				searchResult = ParallelSearch::Search(table, board, parallelConfig, true);
+			} else {
+				searchResult = Search::Search(table, board, true, parallelConfig.tablebase, parallelConfig.book, {}, parallelConfig.search);
+			}
 
 			int idx = Util::BitMaskToIndex(searchResult.move);
 			chosenMoveIndex = idx / 8;
 			LOG("Playing move: " << chosenMoveIndex + 1);
 		} else {
+			// Search the replies while the human thinks
+			std::unique_ptr<Ponderer> ponderer = ponder ? std::make_unique<Ponderer>(table, board, parallelConfig.tablebase, parallelConfig.book, parallelConfig.search) : NULL;
+
 			// Human can move
 			while (true) {
 				std::cout << "Your move index: ";
 				std::string line;
-				std::getline(std::cin, line);
+				if (!std::getline(std::cin, line))
+					return EXIT_SUCCESS;
 				bool invalid = false;
 				try {
 					chosenMoveIndex = std::stoi(line) - 1;
@@ -91,6 +536,15 @@ int main(int argc, char* argv[]) {
 
 				break;
 			}
+
+			if (ponderer) {
+				bool ponderHit = ponderer->Finish(chosenMoveIndex);
+				LOG(
+					"[Pondered] searched: " << Util::NumToStr(ponderer->GetTotalSearched()) <<
+					", replies solved: " << ponderer->GetNumSolved() <<
+					", this reply solved: " << (ponderHit ? "yes" : "no")
+				);
+			}
 		}
 
 		movesStr += '1' + chosenMoveIndex;
@@ -0,0 +1,85 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::Open(const std::filesystem::path& path, Mode mode) {
+	Close();
+
+#ifdef _WIN32
+	fileHandle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		fileHandle = NULL;
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+		Close();
+		return false;
+	}
+
+	mappingHandle = CreateFileMappingW(fileHandle, NULL, (mode == COPY_ON_WRITE) ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+	if (!mappingHandle) {
+		Close();
+		return false;
+	}
+
+	data = (uint8_t*)MapViewOfFile(mappingHandle, (mode == COPY_ON_WRITE) ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		Close();
+		return false;
+	}
+
+	size = fileSize.QuadPart;
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	int prot = (mode == COPY_ON_WRITE) ? (PROT_READ | PROT_WRITE) : PROT_READ;
+	void* mapping = mmap(NULL, fileStat.st_size, prot, MAP_PRIVATE, fd, 0);
+	close(fd); // The mapping keeps the file alive
+
+	if (mapping == MAP_FAILED)
+		return false;
+
+	data = (uint8_t*)mapping;
+	size = fileStat.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (mappingHandle)
+		CloseHandle(mappingHandle);
+	if (fileHandle)
+		CloseHandle(fileHandle);
+	mappingHandle = NULL;
+	fileHandle = NULL;
+#else
+	if (data)
+		munmap(data, size);
+#endif
+
+	data = NULL;
+	size = 0;
+}
\ No newline at end of file
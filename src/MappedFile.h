@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Framework.h"
+
+// Memory-mapped file
+struct MappedFile {
+	enum Mode {
+		READ_ONLY,
+		COPY_ON_WRITE // Writes are private to this process and never reach the file
+	};
+
+	uint8_t* data = NULL;
+	size_t size = 0;
+
+	MappedFile() = default;
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+
+	MappedFile(MappedFile&& other) noexcept {
+		*this = std::move(other);
+	}
+
+	MappedFile& operator=(MappedFile&& other) noexcept {
+		if (this != &other) {
+			Close();
+			std::swap(data, other.data);
+			std::swap(size, other.size);
+#ifdef _WIN32
+			std::swap(fileHandle, other.fileHandle);
+			std::swap(mappingHandle, other.mappingHandle);
+#endif
+		}
+		return *this;
+	}
+
+	~MappedFile() {
+		Close();
+	}
+
+	// Returns false if the file couldn't be opened or mapped
+	bool Open(const std::filesystem::path& path, Mode mode);
+	void Close();
+
+	bool IsOpen() const {
+		return data != NULL;
+	}
+
+private:
+#ifdef _WIN32
+	void* fileHandle = NULL;
+	void* mappingHandle = NULL;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,305 @@
+#include "Match.h"
+#include "PositionFile.h"
+#include "Testing.h"
+
+// Pairs before the SPRT may decide, so the variance estimate means something
+constexpr int MIN_DECISION_PAIRS = 10;
+
+enum {
+	ENGINE_BASE,
+	ENGINE_TEST
+};
+
+constexpr const char* ENGINE_NAMES[] = { "base", "test" };
+
+struct MoveRecord {
+	int engine;
+	int ply;
+	uint64_t nodes;
+	double time;
+};
+
+bool Match::ParseEngineConfig(const std::string& str, EngineConfig& outConfig) {
+	std::unordered_map<std::string, float*> weightKeys;
+	for (auto& field : Eval::MOVE_WEIGHT_FIELDS)
+		weightKeys[field.name] = &(outConfig.search.moveWeights.*field.member);
+
+	std::stringstream stream = std::stringstream(str);
+	std::string option;
+	while (std::getline(stream, option, ',')) {
+		if (option.empty() || option == "default")
+			continue;
+
+		size_t split = option.find('=');
+		if (split == std::string::npos) {
+			WARN("Bad engine option \"" << option << "\", should be key=value");
+			return false;
+		}
+
+		std::string key = option.substr(0, split);
+		std::string valueStr = option.substr(split + 1);
+		try {
+			if (weightKeys.count(key)) {
+				*weightKeys[key] = std::stof(valueStr);
+			} else if (key == "tablelog2") {
+				outConfig.tableSizeLog2 = std::stoi(valueStr);
+				if (outConfig.tableSizeLog2 < 1 || outConfig.tableSizeLog2 > 40)
+					throw std::out_of_range(key);
+			} else if (key == "nearleaflog2") {
+				outConfig.nearLeafSizeLog2 = std::stoi(valueStr);
+				if (outConfig.nearLeafSizeLog2 < 0 || outConfig.nearLeafSizeLog2 > 30)
+					throw std::out_of_range(key);
+			} else if (key == "nearleaf") {
+				outConfig.search.nearLeafEmptyCells = std::stoi(valueStr);
+				if (outConfig.search.nearLeafEmptyCells < 0 || outConfig.search.nearLeafEmptyCells > BOARD_CELL_COUNT)
+					throw std::out_of_range(key);
+			} else if (key == "endgame") {
+				outConfig.search.endgameEmptyCells = std::stoi(valueStr);
+				if (outConfig.search.endgameEmptyCells < 0 || outConfig.search.endgameEmptyCells > BOARD_CELL_COUNT)
+					throw std::out_of_range(key);
+			} else if (key == "rules") {
+				outConfig.search.instaSolverRules = (uint32_t)std::stoul(valueStr, NULL, 0) & InstaSolver::ALL_RULES;
+			} else {
+				WARN("Unknown engine option \"" << key << "\"");
+				return false;
+			}
+		} catch (std::exception& e) {
+			WARN("Bad value for engine option \"" << key << "\": \"" << valueStr << "\"");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool IsPlayable(const BoardState& board) {
+	return board.GetValidMoveMask() && !Eval::IsWonAfterMove(board);
+}
+
+static std::vector<BoardState> LoadOpenings(const Match::Config& config) {
+	if (config.openingsPath.empty())
+		return Testing::GenerateUniquePositions(config.openingPly, config.maxPairs, config.seed);
+
+	std::vector<BoardState> boards, openings;
+	PositionFile::ReadBoards(config.openingsPath, boards);
+	for (const BoardState& board : boards)
+		if (IsPlayable(board) && openings.size() < (size_t)config.maxPairs)
+			openings.push_back(board);
+	return openings;
+}
+
+// Plays the opening out, engines[0] moving first, returns false if stopped
+static bool PlayGame(
+	const BoardState& opening, const Match::EngineConfig* engines[2], int engineIds[2], TranspositionTable* tables[2],
+	const std::function<bool()>& stopCheck, std::vector<MoveRecord>& outMoves) {
+
+	tables[0]->Reset();
+	tables[1]->Reset();
+
+	BoardState board = opening;
+	for (int turn = 0; board.GetValidMoveMask(); turn++) {
+		int side = turn % 2;
+
+		Timer timer = {};
+		SearchResult result = Search::Search(tables[side], board, false, NULL, NULL, stopCheck, engines[side]->search);
+		if (result.stopped)
+			return false;
+
+		outMoves.push_back(MoveRecord{ engineIds[side], board.moveCount, result.totalSearched, timer.Elapsed() });
+
+		if (result.move & board.winMasks[board.turnSwitch])
+			break; // Won
+
+		board.FillMove(result.move);
+	}
+
+	return true;
+}
+
+// Sequential probability ratio test on the log cost ratios, with the normal approximation
+struct Sprt {
+	double mu1; // Mean log ratio under H1 (H0 is 0)
+	double lowerBound, upperBound;
+
+	int n = 0;
+	double sum = 0, sumSq = 0;
+
+	Sprt(const Match::Config& config) {
+		mu1 = log(config.minSpeedup);
+		lowerBound = log(config.beta / (1 - config.alpha));
+		upperBound = log((1 - config.beta) / config.alpha);
+	}
+
+	void Add(double logRatio) {
+		n++;
+		sum += logRatio;
+		sumSq += logRatio * logRatio;
+	}
+
+	double GetMean() const {
+		return sum / MAX(n, 1);
+	}
+
+	double GetVariance() const {
+		if (n < 2)
+			return 1;
+
+		double mean = GetMean();
+		return MAX((sumSq - n * mean * mean) / (n - 1), 1e-12);
+	}
+
+	double GetLLR() const {
+		return mu1 * (sum - n * mu1 / 2) / GetVariance();
+	}
+
+	Match::Decision GetDecision() const {
+		if (n < MIN_DECISION_PAIRS)
+			return Match::DECISION_NONE;
+
+		double llr = GetLLR();
+		if (llr >= upperBound)
+			return Match::DECISION_FASTER;
+		if (llr <= lowerBound)
+			return Match::DECISION_NOT_FASTER;
+		return Match::DECISION_NONE;
+	}
+
+	void FillResult(Match::Result& outResult) const {
+		double mean = GetMean();
+		double margin = 1.96 * sqrt(GetVariance() / MAX(n, 1));
+		outResult.numPairs = n;
+		outResult.llr = GetLLR();
+		outResult.speedup = exp(mean);
+		outResult.speedupLow = exp(mean - margin);
+		outResult.speedupHigh = exp(mean + margin);
+	}
+};
+
+Match::Result Match::Run(const Config& config, const std::filesystem::path& movesPath) {
+	RASSERT(config.numThreads >= 1, "Bad thread count: " << config.numThreads);
+	RASSERT(config.minSpeedup > 1, "The minimum speedup must be above 1: " << config.minSpeedup);
+
+	Result result = {};
+
+	std::vector<BoardState> openings = LoadOpenings(config);
+	if (openings.empty()) {
+		WARN("No openings to play");
+		return result;
+	}
+
+	std::ofstream movesStream;
+	if (!movesPath.empty()) {
+		movesStream.open(movesPath);
+		if (!movesStream) {
+			WARN("Failed to create \"" << movesPath.string() << "\"");
+			return result;
+		}
+		movesStream << "pair,game,engine,ply,nodes,time" << std::endl;
+	}
+
+	LOG(
+		"Playing up to " << openings.size() << " game pairs (" << config.numThreads << " at once), " <<
+		"test for a speedup of " << config.minSpeedup << " in " << (config.metric == METRIC_TIME ? "time" : "nodes") <<
+		" (alpha: " << config.alpha << ", beta: " << config.beta << ")..."
+	);
+
+	Sprt sprt = Sprt(config);
+	std::mutex resultMutex;
+	std::atomic<bool> decided = false;
+	std::atomic<size_t> nextPair = 0;
+	uint64_t totalNodes[2] = {};
+	double totalTime[2] = {};
+
+	auto fnStopCheck = [&]() -> bool {
+		return decided.load(std::memory_order_relaxed);
+	};
+
+	auto fnWork = [&]() {
+		const EngineConfig* engines[2] = { &config.base, &config.test };
+		TranspositionTable baseTable = TranspositionTable(config.base.tableSizeLog2);
+		TranspositionTable testTable = TranspositionTable(config.test.tableSizeLog2);
+		if (config.base.nearLeafSizeLog2)
+			baseTable.EnableNearLeaf(config.base.nearLeafSizeLog2);
+		if (config.test.nearLeafSizeLog2)
+			testTable.EnableNearLeaf(config.test.nearLeafSizeLog2);
+
+		while (!decided) {
+			size_t pairIndex = nextPair++;
+			if (pairIndex >= openings.size())
+				break;
+
+			// Each engine gets to move first once
+			std::vector<MoveRecord> games[2];
+			bool finished = true;
+			for (int game = 0; game < 2 && finished; game++) {
+				int first = game;
+				const EngineConfig* gameEngines[2] = { engines[first], engines[!first] };
+				int gameEngineIds[2] = { first, !first };
+				TranspositionTable* gameTables[2] = { first ? &testTable : &baseTable, first ? &baseTable : &testTable };
+				finished = PlayGame(openings[pairIndex], gameEngines, gameEngineIds, gameTables, fnStopCheck, games[game]);
+			}
+
+			if (!finished)
+				break;
+
+			double cost[2] = {};
+			uint64_t pairNodes[2] = {};
+			double pairTime[2] = {};
+			for (auto& moves : games) {
+				for (MoveRecord& move : moves) {
+					pairNodes[move.engine] += move.nodes;
+					pairTime[move.engine] += move.time;
+				}
+			}
+			for (int i = 0; i < 2; i++)
+				cost[i] = (config.metric == METRIC_TIME) ? MAX(pairTime[i], 1e-6) : (double)MAX(pairNodes[i], (uint64_t)1);
+
+			std::lock_guard<std::mutex> lock(resultMutex);
+			if (decided)
+				break;
+
+			if (movesStream.is_open()) {
+				for (int game = 0; game < 2; game++)
+					for (MoveRecord& move : games[game])
+						movesStream << pairIndex << "," << game << "," << ENGINE_NAMES[move.engine] << "," << move.ply << "," << move.nodes << "," << move.time << '\n';
+			}
+
+			for (int i = 0; i < 2; i++) {
+				totalNodes[i] += pairNodes[i];
+				totalTime[i] += pairTime[i];
+			}
+
+			sprt.Add(log(cost[ENGINE_BASE] / cost[ENGINE_TEST]));
+			result.decision = sprt.GetDecision();
+			sprt.FillResult(result);
+			LOG(
+				" > Pair " << sprt.n << " (opening " << pairIndex << "): base/test " << (cost[ENGINE_BASE] / cost[ENGINE_TEST]) <<
+				", speedup: " << result.speedup << " [" << result.speedupLow << ", " << result.speedupHigh << "]" <<
+				", LLR: " << result.llr << " [" << sprt.lowerBound << ", " << sprt.upperBound << "]"
+			);
+
+			if (result.decision != DECISION_NONE)
+				decided = true;
+		}
+	};
+
+	Timer timer = {};
+	std::vector<std::thread> threads;
+	for (int i = 1; i < config.numThreads; i++)
+		threads.push_back(std::thread(fnWork));
+	fnWork();
+	for (auto& thread : threads)
+		thread.join();
+
+	for (int i = 0; i < 2; i++) {
+		LOG(
+			" > " << ENGINE_NAMES[i] << ": searched " << Util::NumToStr(totalNodes[i]) << " in " << totalTime[i] << "s" <<
+			" (moves/sec: " << Util::NumToStr(totalNodes[i] / MAX(totalTime[i], 1e-9)) << ")"
+		);
+	}
+	LOG(
+		"Result: " << DECISION_NAMES[result.decision] << " after " << result.numPairs << " pairs in " << timer.Elapsed() << "s" <<
+		", speedup: " << result.speedup << " [" << result.speedupLow << ", " << result.speedupHigh << "]"
+	);
+	return result;
+}
\ No newline at end of file
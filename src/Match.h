@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Search.h"
+
+// Engine-versus-engine matches, to judge search changes by their real solve cost
+// A base and a test engine configuration play each opening twice with colors swapped (a game pair), pairs run in parallel
+// After every pair, a sequential probability ratio test (SPRT) on the pair's cost ratio decides whether the test engine is faster
+namespace Match {
+	struct EngineConfig {
+		SearchConfig search = {};
+		int tableSizeLog2 = 22; // Each engine's table is cleared before every game
+		int nearLeafSizeLog2 = 0; // Buckets of the table's near-leaf tier, 0 for none
+	};
+
+	// Applies comma-separated "key=value" overrides (e.g. "threat=600,rules=1,tablelog2=20", or "default" for none), returns false on a bad key or value
+	// Keys: tablelog2, nearleaflog2, endgame (SearchConfig::endgameEmptyCells), nearleaf (SearchConfig::nearLeafEmptyCells), rules (InstaSolver rule bit mask),
+	// and the move weights: threat, oddthreat, stackedthreat, makezugzwang, losezugzwang, closecolumn, offcenter
+	bool ParseEngineConfig(const std::string& str, EngineConfig& outConfig);
+
+	enum Metric {
+		METRIC_TIME,
+		METRIC_NODES
+	};
+
+	struct Config {
+		EngineConfig base = {}, test = {};
+		Metric metric = METRIC_TIME;
+
+		int openingPly = 12;
+		int maxPairs = 200; // Stops here if the SPRT hasn't decided yet
+		int numThreads = 1;
+		uint64_t seed = 0;
+
+		// Optional position file of openings, used in order instead of random ones
+		std::string openingsPath = {};
+
+		// H0: the test engine is no faster, H1: it is at least minSpeedup times faster
+		double minSpeedup = 1.05;
+		double alpha = 0.05, beta = 0.05; // False positive and false negative rates
+	};
+
+	enum Decision {
+		DECISION_NONE, // Ran out of pairs first
+		DECISION_FASTER, // Accepted H1
+		DECISION_NOT_FASTER // Accepted H0
+	};
+
+	constexpr const char* DECISION_NAMES[] = { "undecided", "faster", "not faster" };
+
+	struct Result {
+		Decision decision = DECISION_NONE;
+		int numPairs = 0;
+		double llr = 0;
+		double speedup = 1; // Geometric mean of the pairs' base/test cost ratios
+		double speedupLow = 1, speedupHigh = 1; // 95% confidence interval
+	};
+
+	// Writes a CSV row per move to movesPath if it's not empty
+	Result Run(const Config& config, const std::filesystem::path& movesPath = {});
+}
\ No newline at end of file
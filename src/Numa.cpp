@@ -0,0 +1,158 @@
+#include "Numa.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// From <numaif.h>, so we don't need libnuma
+constexpr int MPOL_BIND_MODE = 2;
+constexpr int MPOL_INTERLEAVE_MODE = 3;
+constexpr unsigned MPOL_MF_MOVE_FLAG = 1 << 1;
+#endif
+
+// Parses lists like "0-3,8-11"
+static std::vector<int> ParseCpuList(const std::string& str) {
+	std::vector<int> result;
+	std::stringstream stream = std::stringstream(str);
+	std::string range;
+	while (std::getline(stream, range, ',')) {
+		if (range.empty() || !isdigit(range[0]))
+			continue;
+
+		size_t dashPos = range.find('-');
+		int first = std::stoi(range.substr(0, dashPos));
+		int last = (dashPos == std::string::npos) ? first : std::stoi(range.substr(dashPos + 1));
+		for (int cpu = first; cpu <= last; cpu++)
+			result.push_back(cpu);
+	}
+	return result;
+}
+
+static Numa::Topology MakeTopology() {
+	Numa::Topology topology = {};
+
+#ifdef __linux__
+	for (int node = 0; ; node++) {
+		std::ifstream stream = std::ifstream(STR("/sys/devices/system/node/node" << node << "/cpulist"));
+		if (!stream)
+			break;
+
+		std::string line;
+		std::getline(stream, line);
+		topology.nodeCpus.push_back(ParseCpuList(line));
+	}
+#endif
+
+	if (topology.nodeCpus.empty()) {
+		std::vector<int> cpus = std::vector<int>(MAX(1, std::thread::hardware_concurrency()));
+		std::iota(cpus.begin(), cpus.end(), 0);
+		topology.nodeCpus.push_back(cpus);
+	}
+
+	return topology;
+}
+
+const Numa::Topology& Numa::GetTopology() {
+	static Topology topology = MakeTopology();
+	return topology;
+}
+
+void Numa::LogTopology() {
+	const Topology& topology = GetTopology();
+	std::stringstream nodesStream;
+	for (int i = 0; i < (int)topology.nodeCpus.size(); i++)
+		nodesStream << (i ? ", " : "") << "node " << i << ": " << topology.nodeCpus[i].size() << " cpus";
+
+	LOG("Topology: " << topology.nodeCpus.size() << " NUMA nodes, " << topology.GetNumCpus() << " cpus (" << nodesStream.str() << ")");
+}
+
+bool Numa::PlaceMemory(void* ptr, size_t size, Placement placement, int numNodes) {
+	numNodes = CLAMP(numNodes, 1, (int)GetTopology().nodeCpus.size());
+	if (placement == PLACEMENT_DEFAULT)
+		return true;
+
+#ifdef __linux__
+	constexpr int MAX_NODES = 64;
+	if (numNodes > MAX_NODES)
+		return false;
+
+	// mbind() only takes whole pages
+	size_t pageSize = sysconf(_SC_PAGESIZE);
+	uintptr_t start = ((uintptr_t)ptr + pageSize - 1) & ~(pageSize - 1);
+	uintptr_t end = ((uintptr_t)ptr + size) & ~(pageSize - 1);
+	if (end <= start)
+		return true;
+
+	auto fnBind = [](uintptr_t start, uintptr_t end, int mode, unsigned long nodeMask) -> bool {
+		return syscall(SYS_mbind, start, end - start, mode, &nodeMask, MAX_NODES + 1, MPOL_MF_MOVE_FLAG) == 0;
+	};
+
+	if (placement == PLACEMENT_INTERLEAVE) {
+		unsigned long nodeMask = (numNodes == MAX_NODES) ? ~0ul : ((1ul << numNodes) - 1);
+		return fnBind(start, end, MPOL_INTERLEAVE_MODE, nodeMask);
+	} else {
+		size_t numPages = (end - start) / pageSize;
+		bool success = true;
+		for (int node = 0; node < numNodes; node++) {
+			uintptr_t partStart = start + (numPages * node / numNodes) * pageSize;
+			uintptr_t partEnd = start + (numPages * (node + 1) / numNodes) * pageSize;
+			if (partEnd > partStart)
+				success &= fnBind(partStart, partEnd, MPOL_BIND_MODE, 1ul << node);
+		}
+		return success;
+	}
+#else
+	return false;
+#endif
+}
+
+std::vector<int> Numa::GetPinCpus(int numThreads, int numNodes) {
+	const Topology& topology = GetTopology();
+	numNodes = CLAMP(numNodes, 1, (int)topology.nodeCpus.size());
+
+	std::vector<int> result;
+	for (int i = 0; i < numThreads; i++) {
+		// Alternate nodes, then walk each node's cpus
+		auto& cpus = topology.nodeCpus[i % numNodes];
+		if (cpus.empty())
+			break;
+		result.push_back(cpus[(i / numNodes) % cpus.size()]);
+	}
+	return result;
+}
+
+bool Numa::PinCurrentThread(int cpu) {
+	return SetCurrentThreadCpus({ cpu });
+}
+
+std::vector<int> Numa::GetCurrentThreadCpus() {
+	std::vector<int> result;
+#ifdef __linux__
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	if (pthread_getaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0)
+		return {};
+
+	for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+		if (CPU_ISSET(cpu, &cpuSet))
+			result.push_back(cpu);
+#endif
+	return result;
+}
+
+bool Numa::SetCurrentThreadCpus(const std::vector<int>& cpus) {
+#ifdef __linux__
+	if (cpus.empty())
+		return false;
+
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	for (int cpu : cpus)
+		CPU_SET(cpu, &cpuSet);
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#else
+	return false;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Framework.h"
+
+// NUMA topology, memory placement and thread pinning
+// Only implemented on Linux, elsewhere everything is treated as a single node
+namespace Numa {
+	struct Topology {
+		std::vector<std::vector<int>> nodeCpus; // CPUs of each node
+
+		int GetNumCpus() const {
+			int numCpus = 0;
+			for (auto& cpus : nodeCpus)
+				numCpus += cpus.size();
+			return numCpus;
+		}
+	};
+
+	enum Placement {
+		PLACEMENT_DEFAULT, // First-touch
+		PLACEMENT_INTERLEAVE, // Pages round-robin across nodes
+		PLACEMENT_PARTITION // Contiguous ranges of the memory (and therefore of hashes) per node
+	};
+
+	const Topology& GetTopology();
+	void LogTopology();
+
+	// Applies a placement policy to memory spread across the first numNodes nodes
+	// Pages that were already touched are migrated
+	bool PlaceMemory(void* ptr, size_t size, Placement placement, int numNodes);
+
+	// CPUs to pin threads to, spreading them round-robin across the first numNodes nodes
+	std::vector<int> GetPinCpus(int numThreads, int numNodes);
+
+	bool PinCurrentThread(int cpu);
+
+	// The CPUs the current thread may run on (empty if unknown), to restore them after pinning
+	std::vector<int> GetCurrentThreadCpus();
+	bool SetCurrentThreadCpus(const std::vector<int>& cpus);
+}
\ No newline at end of file
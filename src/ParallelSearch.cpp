@@ -0,0 +1,335 @@
+#include "ParallelSearch.h"
+#include "Book.h"
+#include "Tablebase.h"
+#include "Numa.h"
+
+struct SplitPoint {
+	SplitPoint* parent;
+	TranspositionTable* table;
+	BoardState board;
+
+	std::mutex mutex;
+	SearchCache cache; // cache.min is raised as moves finish
+	Value bestEval;
+	BoardMask bestMove;
+
+	std::atomic<int> numPending;
+	std::atomic<bool> hitCutoff = false;
+
+	// True if this split point or any split point above it has been cut off
+	bool IsAborted() const {
+		for (const SplitPoint* splitPoint = this; splitPoint; splitPoint = splitPoint->parent)
+			if (splitPoint->hitCutoff.load(std::memory_order_relaxed))
+				return true;
+
+		return false;
+	}
+};
+
+struct SplitTask {
+	SplitPoint* splitPoint;
+	BoardMask move;
+};
+
+struct WorkerPool;
+
+struct Worker : SearchSplitter {
+	WorkerPool* pool;
+	int index;
+	SearchInfo info = {};
+
+	// Split point of the move this worker is currently searching, if any
+	SplitPoint* curSplitPoint = NULL;
+
+	std::mutex tasksMutex;
+	std::deque<SplitTask> tasks;
+
+	bool PopOwnTask(SplitPoint* splitPoint, SplitTask& outTask) {
+		std::lock_guard<std::mutex> lock(tasksMutex);
+		if (tasks.empty() || tasks.back().splitPoint != splitPoint)
+			return false;
+
+		outTask = tasks.back();
+		tasks.pop_back();
+		return true;
+	}
+
+	bool StealTask(SplitTask& outTask) {
+		std::lock_guard<std::mutex> lock(tasksMutex);
+		if (tasks.empty())
+			return false;
+
+		outTask = tasks.front();
+		tasks.pop_front();
+		return true;
+	}
+
+	void RunTask(const SplitTask& task);
+
+	void SearchMoves(
+		TranspositionTable* table, const BoardState& board, const BoardMask* moves, int numMoves,
+		SearchCache& cache, Value& bestEval, BoardMask& bestMove, SearchInfo& info
+	) override;
+};
+
+struct WorkerPool {
+	std::vector<Worker*> workers;
+	std::vector<std::thread> threads;
+	std::atomic<bool> quit = false;
+	SearchProgress progress = {};
+	std::vector<int> ownerCpus; // The owning thread's affinity before it was pinned
+
+	WorkerPool(const ParallelSearch::Config& config) {
+		int numThreads = config.numThreads;
+		for (int i = 0; i < numThreads; i++) {
+			Worker* worker = new Worker();
+			worker->pool = this;
+			worker->index = i;
+			worker->minSplitEmptyCells = config.minSplitEmptyCells;
+			worker->info.splitter = worker;
+			worker->info.progress = &progress;
+			worker->info.tablebase = config.tablebase;
+			worker->info.book = config.book;
+			worker->info.config = &config.search;
+			worker->info.stopCheck = [worker]() -> bool {
+				return worker->curSplitPoint && worker->curSplitPoint->IsAborted();
+			};
+			workers.push_back(worker);
+		}
+
+		// Worker 0 is the thread that owns the pool
+		for (int i = 1; i < numThreads; i++) {
+			int pinCpu = (i < (int)config.pinCpus.size()) ? config.pinCpus[i] : -1;
+			threads.push_back(std::thread(&WorkerPool::IdleLoop, this, workers[i], pinCpu));
+		}
+
+		if (!config.pinCpus.empty()) {
+			ownerCpus = Numa::GetCurrentThreadCpus();
+			Numa::PinCurrentThread(config.pinCpus[0]);
+		}
+	}
+
+	~WorkerPool() {
+		quit = true;
+		for (auto& thread : threads)
+			thread.join();
+		if (!ownerCpus.empty())
+			Numa::SetCurrentThreadCpus(ownerCpus);
+		for (Worker* worker : workers)
+			delete worker;
+	}
+
+	bool StealTask(Worker* thief, SplitTask& outTask) {
+		for (int i = 1; i < (int)workers.size(); i++) {
+			Worker* victim = workers[(thief->index + i) % workers.size()];
+			if (victim->StealTask(outTask))
+				return true;
+		}
+		return false;
+	}
+
+	void IdleLoop(Worker* worker, int pinCpu) {
+		if (pinCpu >= 0)
+			Numa::PinCurrentThread(pinCpu);
+
+		SplitTask task;
+		while (!quit) {
+			if (StealTask(worker, task)) {
+				worker->RunTask(task);
+			} else {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	uint64_t GetTotalSearched() const {
+		uint64_t total = 0;
+		for (Worker* worker : workers)
+			total += worker->info.totalSearched;
+		return total;
+	}
+
+	uint64_t GetTotalPruned() const {
+		uint64_t total = 0;
+		for (Worker* worker : workers)
+			total += worker->info.totalPruned;
+		return total;
+	}
+
+#if SEARCH_STATS
+	SearchStats GetTotalStats() const {
+		SearchStats total = {};
+		for (Worker* worker : workers)
+			total.Add(worker->info.stats);
+		return total;
+	}
+#endif
+};
+
+void Worker::RunTask(const SplitTask& task) {
+	SplitPoint* splitPoint = task.splitPoint;
+
+	if (!splitPoint->IsAborted()) {
+		SplitPoint* prevSplitPoint = curSplitPoint;
+		curSplitPoint = splitPoint;
+
+		SearchCache nextCache;
+		{
+			std::lock_guard<std::mutex> lock(splitPoint->mutex);
+			nextCache = splitPoint->cache.ProgressDepth();
+		}
+
+		BoardState nextBoard = splitPoint->board;
+		nextBoard.FillMove(task.move);
+
+		info.stopped = false;
+		Value nextEval = Search::AlphaBetaSearch(splitPoint->table, nextBoard, info, nextCache);
+
+		if (!info.stopped) {
+			nextEval = -nextEval;
+			nextEval.depth++;
+
+			std::lock_guard<std::mutex> lock(splitPoint->mutex);
+			if (nextEval > splitPoint->bestEval) {
+				splitPoint->bestEval = nextEval;
+				splitPoint->bestMove = task.move;
+
+				if (nextEval > splitPoint->cache.min)
+					splitPoint->cache.min = nextEval;
+			}
+
+			if (nextEval >= splitPoint->cache.max)
+				splitPoint->hitCutoff = true;
+		}
+
+		info.stopped = false;
+		curSplitPoint = prevSplitPoint;
+	}
+
+	splitPoint->numPending--;
+}
+
+void Worker::SearchMoves(
+	TranspositionTable* table, const BoardState& board, const BoardMask* moves, int numMoves,
+	SearchCache& cache, Value& bestEval, BoardMask& bestMove, SearchInfo& info) {
+
+	SplitPoint splitPoint = {};
+	splitPoint.parent = curSplitPoint;
+	splitPoint.table = table;
+	splitPoint.board = board;
+	splitPoint.cache = cache;
+	splitPoint.bestEval = bestEval;
+	splitPoint.bestMove = bestMove;
+	splitPoint.numPending = numMoves;
+
+	{
+		// Pushed in reverse so we pop the best-ordered moves, while thieves take the worst-ordered ones
+		std::lock_guard<std::mutex> lock(tasksMutex);
+		for (int i = numMoves - 1; i >= 0; i--)
+			tasks.push_back(SplitTask{ &splitPoint, moves[i] });
+	}
+
+	SplitTask task;
+	while (splitPoint.numPending > 0) {
+		if (PopOwnTask(&splitPoint, task)) {
+			RunTask(task);
+		} else {
+			// The remaining moves are being searched by other workers
+			std::this_thread::yield();
+		}
+	}
+
+	cache.min = splitPoint.cache.min;
+	bestEval = splitPoint.bestEval;
+	bestMove = splitPoint.bestMove;
+
+	// We might have been aborted from above while waiting
+	info.stopped = info.stopCheck();
+}
+
+SearchResult ParallelSearch::Search(TranspositionTable* table, const BoardState& board, const Config& baseConfig, bool log) {
+	Timer timer = {};
+	BoardMask validMoves = board.GetValidMoveMask();
+
+	RASSERT(validMoves, "No valid moves in the position");
+
+	// Positions outside the book's or tablebase's subtree would probe as arbitrary values
+	Config config = baseConfig;
+	if (config.book && !config.book->CoversSubtree(board))
+		config.book = NULL;
+	if (config.tablebase && !config.tablebase->CoversSubtree(board))
+		config.tablebase = NULL;
+	int numThreads = config.numThreads;
+	RASSERT(numThreads >= 1 && numThreads <= MAX_THREADS, "Bad thread count: " << numThreads);
+
+	BoardMask bookMove;
+	Value bookEval;
+	if ((validMoves & board.winMasks[board.turnSwitch]) || (config.book && config.book->ProbeBestMove(board, bookMove, bookEval))) {
+		// Nothing to parallelize
+		return Search::Search(table, board, log, config.tablebase, config.book, {}, config.search);
+	}
+
+	WorkerPool pool = WorkerPool(config);
+	SearchInfo& rootInfo = pool.workers[0]->info;
+
+	Value eval;
+	{
+		std::unique_ptr<ProgressReporter> progressReporter = log ? std::make_unique<ProgressReporter>(&pool.progress, table) : NULL;
+		eval = Search::AlphaBetaSearch(table, board, rootInfo);
+	}
+
+	// The move stored by the search depends on which thread finished first,
+	// so instead we take the first move in static order that achieves the eval
+	BoardMask bestMove = 0;
+	{
+		BoardMask croppedMoves = validMoves;
+		Eval::EvalAndCropValidMoves(board, croppedMoves);
+
+		BoardMask moves[BOARD_SIZE_X];
+		int numMoves = Search::GetOrderedMoves(board, croppedMoves ? croppedMoves : validMoves, 0, moves, NULL, config.search.moveWeights);
+
+		// Null window just below the eval
+		SearchCache rootCache = {};
+		rootCache.min = Value(eval.val - 1);
+		rootCache.max = Value(eval.val);
+
+		for (int i = 0; i < numMoves && !bestMove; i++) {
+			BoardState nextBoard = board;
+			nextBoard.FillMove(moves[i]);
+
+			Value nextEval = -Search::AlphaBetaSearch(table, nextBoard, rootInfo, rootCache.ProgressDepth());
+			if (nextEval >= eval)
+				bestMove = moves[i];
+		}
+
+		if (!bestMove)
+			bestMove = moves[0];
+	}
+
+	double timeElapsed = timer.Elapsed();
+	uint64_t totalSearched = pool.GetTotalSearched();
+
+	if (log) {
+		auto pv = Search::FindPVFromTable(table, board, bestMove);
+		std::string pvStr = {};
+		for (BoardMask move : pv)
+			pvStr += '1' + (int)(Util::BitMaskToIndex(move) / 8);
+
+		LOG(
+			"Eval: " << eval <<
+			", threads: " << numThreads <<
+			", searched: " << Util::NumToStr(totalSearched) << "/" << Util::NumToStr(pool.GetTotalPruned()) <<
+			", moves/sec: " << Util::NumToStr(totalSearched / timeElapsed) <<
+			", tablefillfrac: " << table->GetFillFrac()
+		);
+		LOG(" > PV: " << pvStr);
+	}
+
+	SearchResult result = { bestMove, eval, totalSearched };
+#if SEARCH_STATS
+	result.stats = pool.GetTotalStats();
+	if (log)
+		result.stats.Log();
+#endif
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Search.h"
+
+// Tree-splitting parallel alpha-beta built on Search::AlphaBetaSearch (young brothers wait)
+// Each worker owns a deque of split point moves, idle workers steal from the front of other workers' deques
+namespace ParallelSearch {
+	// Nodes with fewer empty cells are always searched serially
+	constexpr int DEFAULT_MIN_SPLIT_EMPTY_CELLS = 20;
+
+	constexpr int MAX_THREADS = 256;
+
+	struct Config {
+		int numThreads = 1;
+		int minSplitEmptyCells = DEFAULT_MIN_SPLIT_EMPTY_CELLS;
+
+		// Optional CPU for each thread to be pinned to (including the calling thread)
+		std::vector<int> pinCpus = {};
+
+		// Optional, probed by every worker
+		const Tablebase* tablebase = NULL;
+		const Book* book = NULL;
+
+		SearchConfig search = {};
+	};
+
+	// Searches the root, then picks the best move deterministically
+	// The eval and best move do not depend on the number of threads
+	SearchResult Search(TranspositionTable* table, const BoardState& board, const Config& config, bool log);
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+static int OpenCounter(PerfCounters::Counter counter) {
+	perf_event_attr attr = {};
+	attr.size = sizeof(attr);
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	auto fnCacheConfig = [](uint64_t cache, uint64_t op, uint64_t result) -> uint64_t {
+		return cache | (op << 8) | (result << 16);
+	};
+
+	switch (counter) {
+	case PerfCounters::CYCLES:
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_CPU_CYCLES;
+		break;
+	case PerfCounters::INSTRUCTIONS:
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+		break;
+	case PerfCounters::L1D_MISSES:
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.config = fnCacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+		break;
+	case PerfCounters::LLC_MISSES:
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		break;
+	case PerfCounters::DTLB_MISSES:
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.config = fnCacheConfig(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+		break;
+	case PerfCounters::BRANCH_MISSES:
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+		break;
+	default:
+		return -1;
+	}
+
+	// This thread, any cpu
+	return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+struct CounterReading {
+	uint64_t value, timeEnabled, timeRunning;
+};
+
+static bool ReadCounter(int fd, CounterReading& outReading) {
+	return read(fd, &outReading, sizeof(outReading)) == sizeof(outReading);
+}
+#endif
+
+PerfCounters::PerfCounters() {
+	for (int i = 0; i < NUM_COUNTERS; i++) {
+#ifdef __linux__
+		fds[i] = OpenCounter((Counter)i);
+#else
+		fds[i] = -1;
+#endif
+	}
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+	for (int fd : fds)
+		if (fd >= 0)
+			close(fd);
+#endif
+}
+
+void PerfCounters::Start() {
+#ifdef __linux__
+	for (int i = 0; i < NUM_COUNTERS; i++) {
+		if (fds[i] < 0)
+			continue;
+
+		// Resetting clears the count but not the times, so those are measured from here
+		ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+		CounterReading reading = {};
+		ReadCounter(fds[i], reading);
+		startTimeEnabled[i] = reading.timeEnabled;
+		startTimeRunning[i] = reading.timeRunning;
+
+		ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+	}
+#endif
+}
+
+void PerfCounters::Stop() {
+#ifdef __linux__
+	for (int fd : fds)
+		if (fd >= 0)
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+	for (int i = 0; i < NUM_COUNTERS; i++) {
+		if (fds[i] < 0)
+			continue;
+
+		CounterReading reading = {};
+		if (!ReadCounter(fds[i], reading))
+			continue;
+
+		uint64_t timeEnabled = reading.timeEnabled - startTimeEnabled[i];
+		uint64_t timeRunning = reading.timeRunning - startTimeRunning[i];
+		if (!timeRunning)
+			continue;
+
+		values[i] += (double)reading.value * ((double)timeEnabled / (double)timeRunning);
+	}
+#endif
+}
+
+void PerfCounters::Reset() {
+	std::fill(values, values + NUM_COUNTERS, 0);
+}
+
+std::string PerfCounters::ToString(uint64_t numUnits) const {
+	std::stringstream stream;
+	stream << std::fixed << std::setprecision(2);
+
+	for (int i = 0; i < NUM_COUNTERS; i++) {
+		stream << (i ? ", " : "") << COUNTER_NAMES[i] << ": ";
+		if (IsAvailable((Counter)i)) {
+			stream << (values[i] / MAX(numUnits, 1));
+		} else {
+			stream << "n/a";
+		}
+	}
+
+	return stream.str();
+}
\ No newline at end of file
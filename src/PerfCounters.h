@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Framework.h"
+
+// Hardware performance counters of the calling thread (Linux perf_event_open)
+// Counters the kernel or CPU doesn't allow are left unavailable, everywhere else they all are
+struct PerfCounters {
+	enum Counter {
+		CYCLES,
+		INSTRUCTIONS,
+		L1D_MISSES,
+		LLC_MISSES,
+		DTLB_MISSES,
+		BRANCH_MISSES,
+
+		NUM_COUNTERS
+	};
+
+	constexpr static const char* COUNTER_NAMES[NUM_COUNTERS] = {
+		"cycles", "instructions", "L1d misses", "LLC misses", "dTLB misses", "branch misses"
+	};
+
+	// Accumulated over every Start()/Stop() pair, scaled up if the kernel had to multiplex counters
+	double values[NUM_COUNTERS] = {};
+
+	PerfCounters();
+	~PerfCounters();
+
+	PerfCounters(const PerfCounters& other) = delete;
+	PerfCounters& operator=(const PerfCounters& other) = delete;
+
+	bool IsAvailable(Counter counter) const {
+		return fds[counter] >= 0;
+	}
+
+	bool IsAnyAvailable() const {
+		for (int i = 0; i < NUM_COUNTERS; i++)
+			if (IsAvailable((Counter)i))
+				return true;
+		return false;
+	}
+
+	void Start();
+	void Stop();
+	void Reset();
+
+	// E.g. "cycles: 123.4, instructions: 234.5, ..." per unit (usually per node searched)
+	std::string ToString(uint64_t numUnits) const;
+
+private:
+	int fds[NUM_COUNTERS];
+
+	// Times at the last Start(), as the kernel only reports them since the counter was opened
+	uint64_t startTimeEnabled[NUM_COUNTERS] = {};
+	uint64_t startTimeRunning[NUM_COUNTERS] = {};
+};
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "PerfectHash.h"
+
+template <typename T>
+static void RunThreads(int numThreads, T&& fnWork) {
+	std::vector<std::thread> threads;
+	for (int i = 1; i < numThreads; i++)
+		threads.push_back(std::thread(fnWork, i));
+	fnWork(0);
+	for (auto& thread : threads)
+		thread.join();
+}
+
+std::vector<uint64_t> PerfectHash::Build(const std::vector<uint64_t>& keys, uint64_t dataOffset, Header& outHeader, int numThreads) {
+	RASSERT(dataOffset % sizeof(uint64_t) == 0, "Unaligned perfect hash offset " << dataOffset);
+
+	std::vector<std::vector<uint64_t>> levelBits;
+	std::vector<std::vector<uint64_t>> levelRanks;
+
+	std::vector<uint64_t> remaining = keys;
+	uint64_t numPlaced = 0;
+	for (int levelIndex = 0; levelIndex < MAX_LEVELS && !remaining.empty(); levelIndex++) {
+		constexpr uint64_t BLOCK_BITS = RANK_BLOCK_WORDS * 64;
+		uint64_t numSlots = (uint64_t)(remaining.size() * GAMMA) + 1;
+		uint64_t numWords = ((numSlots + BLOCK_BITS - 1) / BLOCK_BITS) * RANK_BLOCK_WORDS;
+		numSlots = numWords * 64;
+
+		// Slots hit at least once, and more than once
+		std::vector<std::atomic<uint64_t>> hitBits = std::vector<std::atomic<uint64_t>>(numWords);
+		std::vector<std::atomic<uint64_t>> collisionBits = std::vector<std::atomic<uint64_t>>(numWords);
+		RunThreads(numThreads, [&](int threadIndex) {
+			for (size_t i = threadIndex; i < remaining.size(); i += numThreads) {
+				uint64_t slot = GetSlot(remaining[i], levelIndex, numSlots);
+				uint64_t bit = 1ull << (slot % 64);
+				if (hitBits[slot / 64].fetch_or(bit, std::memory_order_relaxed) & bit)
+					collisionBits[slot / 64].fetch_or(bit, std::memory_order_relaxed);
+			}
+		});
+
+		std::vector<uint64_t>& bits = levelBits.emplace_back(numWords);
+		for (uint64_t w = 0; w < numWords; w++)
+			bits[w] = hitBits[w] & ~collisionBits[w];
+
+		std::vector<uint64_t>& ranks = levelRanks.emplace_back(numWords / RANK_BLOCK_WORDS + 1);
+		for (uint64_t block = 0; block < ranks.size(); block++) {
+			ranks[block] = numPlaced;
+			for (uint64_t w = block * RANK_BLOCK_WORDS; w < MIN((block + 1) * RANK_BLOCK_WORDS, numWords); w++)
+				numPlaced += Util::BitCount64(bits[w]);
+		}
+
+		// Keys that collided go on to the next level
+		std::vector<std::vector<uint64_t>> threadRemaining = std::vector<std::vector<uint64_t>>(numThreads);
+		RunThreads(numThreads, [&](int threadIndex) {
+			for (size_t i = threadIndex; i < remaining.size(); i += numThreads) {
+				uint64_t slot = GetSlot(remaining[i], levelIndex, numSlots);
+				if (!(bits[slot / 64] & (1ull << (slot % 64))))
+					threadRemaining[threadIndex].push_back(remaining[i]);
+			}
+		});
+
+		remaining.clear();
+		for (auto& threadKeys : threadRemaining)
+			remaining.insert(remaining.end(), threadKeys.begin(), threadKeys.end());
+	}
+	std::sort(remaining.begin(), remaining.end());
+
+	outHeader = {};
+	outHeader.count = keys.size();
+	outHeader.numLevels = levelBits.size();
+	outHeader.numFallbackKeys = remaining.size();
+
+	std::vector<uint64_t> data;
+	auto fnAppend = [&](const std::vector<uint64_t>& words) -> uint64_t {
+		uint64_t offset = dataOffset + data.size() * sizeof(uint64_t);
+		data.insert(data.end(), words.begin(), words.end());
+		return offset;
+	};
+
+	for (size_t i = 0; i < levelBits.size(); i++) {
+		Level& level = outHeader.levels[i];
+		level.numWords = levelBits[i].size();
+		level.bitsOffset = fnAppend(levelBits[i]);
+		level.ranksOffset = fnAppend(levelRanks[i]);
+	}
+	outHeader.fallbackKeysOffset = fnAppend(remaining);
+	return data;
+}
+
+bool PerfectHash::IsValid(const Header& header, uint64_t fileSize) {
+	bool valid = header.count > 0 && header.numLevels <= MAX_LEVELS;
+	for (uint32_t i = 0; valid && i < header.numLevels; i++) {
+		const Level& level = header.levels[i];
+		valid =
+			level.numWords > 0 && level.numWords % RANK_BLOCK_WORDS == 0 &&
+			level.bitsOffset % sizeof(uint64_t) == 0 && level.ranksOffset % sizeof(uint64_t) == 0 &&
+			Util::IsRangeInSize(level.bitsOffset, level.numWords, sizeof(uint64_t), fileSize) &&
+			Util::IsRangeInSize(level.ranksOffset, level.numWords / RANK_BLOCK_WORDS + 1, sizeof(uint64_t), fileSize);
+	}
+
+	return
+		valid &&
+		header.numFallbackKeys <= header.count && header.fallbackKeysOffset % sizeof(uint64_t) == 0 &&
+		Util::IsRangeInSize(header.fallbackKeysOffset, header.numFallbackKeys, sizeof(uint64_t), fileSize);
+}
+
+uint64_t PerfectHash::GetIndex(const Header& header, const uint8_t* fileData, uint64_t key) {
+	for (uint32_t i = 0; i < header.numLevels; i++) {
+		const Level& level = header.levels[i];
+		const uint64_t* bits = (const uint64_t*)(fileData + level.bitsOffset);
+
+		uint64_t slot = GetSlot(key, i, level.numWords * 64);
+		uint64_t word = bits[slot / 64];
+		uint64_t bit = 1ull << (slot % 64);
+		if (!(word & bit))
+			continue;
+
+		uint64_t block = slot / (RANK_BLOCK_WORDS * 64);
+		uint64_t index = ((const uint64_t*)(fileData + level.ranksOffset))[block];
+		for (uint64_t w = block * RANK_BLOCK_WORDS; w < slot / 64; w++)
+			index += Util::BitCount64(bits[w]);
+
+		// (Only out of range if the ranks are corrupt)
+		return MIN(index + Util::BitCount64(word & (bit - 1)), header.count - 1);
+	}
+
+	if (!header.numFallbackKeys)
+		return 0;
+
+	const uint64_t* fallbackKeys = (const uint64_t*)(fileData + header.fallbackKeysOffset);
+	uint64_t fallbackIndex = std::lower_bound(fallbackKeys, fallbackKeys + header.numFallbackKeys, key) - fallbackKeys;
+	return header.count - header.numFallbackKeys + MIN(fallbackIndex, header.numFallbackKeys - 1);
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Framework.h"
+#include "Util.h"
+
+// Minimal perfect hash of a set of 64-bit keys (BBHash), for files that store values without their keys
+// Maps each key of the set to a unique index below the key count, any other key to an arbitrary index in range
+//
+// The hash is built in levels: each level has a bit per slot, keys hashing to a slot alone claim it,
+// the rest retry on the next level. A key's index is the number of claimed slots before its own,
+// counted with a prefix rank per 512 bits. Keys still left after MAX_LEVELS are stored explicitly
+namespace PerfectHash {
+	constexpr int MAX_LEVELS = 24;
+
+	// Slots per key on each level, higher builds faster and probes fewer levels but is larger
+	constexpr double GAMMA = 2;
+
+	constexpr int RANK_BLOCK_WORDS = 8; // 512 bits
+
+	// Offsets are from the start of the file
+	struct Level {
+		uint64_t numWords;
+		uint64_t bitsOffset; // uint64_t[numWords]
+		uint64_t ranksOffset; // uint64_t[numWords / RANK_BLOCK_WORDS + 1], claimed slots before each block
+	};
+
+	struct Header {
+		uint64_t count;
+		uint32_t numLevels, pad;
+		Level levels[MAX_LEVELS];
+		uint64_t numFallbackKeys;
+		uint64_t fallbackKeysOffset; // Sorted uint64_t[numFallbackKeys], indexed after every level's keys
+	};
+
+	// Slot of the key on a level
+	inline uint64_t GetSlot(uint64_t key, int level, uint64_t numSlots) {
+		return Util::FastHash(key + (level + 1) * 0x9E3779B97F4A7C15ull) % numSlots;
+	}
+
+	// Fills in the header and returns the hash's arrays, laid out from dataOffset (a multiple of 8) in the file
+	std::vector<uint64_t> Build(const std::vector<uint64_t>& keys, uint64_t dataOffset, Header& outHeader, int numThreads);
+
+	// Whether the set isn't empty and every array GetIndex() reads lies within the file
+	bool IsValid(const Header& header, uint64_t fileSize);
+
+	// Index of the key, arbitrary (but in range) if the key isn't in the set
+	uint64_t GetIndex(const Header& header, const uint8_t* fileData, uint64_t key);
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "Perft.h"
+
+// Below this, probing costs more than counting
+constexpr int MIN_HASH_DEPTH = 3;
+
+// The root is expanded this many plies into tasks for the threads
+constexpr int SPLIT_PLY = 4;
+
+Perft::HashTable::HashTable(int sizeLog2) {
+	size = 1ull << sizeLog2;
+	entries = (Entry*)calloc(size, sizeof(Entry));
+	RASSERT(entries, "Failed to allocate perft hash table");
+}
+
+Perft::HashTable::~HashTable() {
+	free(entries);
+}
+
+bool Perft::HashTable::Find(uint64_t key, int depth, uint64_t& outCount) const {
+	Entry entry = entries[Util::FastHash(key) & (size - 1)];
+	if ((entry.check ^ entry.count) != (key | ((uint64_t)depth << KEY_BITS)))
+		return false;
+
+	outCount = entry.count;
+	return true;
+}
+
+void Perft::HashTable::Store(uint64_t key, int depth, uint64_t count) {
+	Entry& entry = entries[Util::FastHash(key) & (size - 1)];
+	entry.check = (key | ((uint64_t)depth << KEY_BITS)) ^ count;
+	entry.count = count;
+}
+
+// Calls fnChild(nextBoard, multiplicity) for each non-winning move, returns the number of winning moves
+// Multiplicity is 2 for moves standing in for their mirror image
+template <typename T>
+static uint64_t ForEachMove(const BoardState& board, bool useSymmetry, T fnChild) {
+	BoardMask winMask = board.winMasks[board.turnSwitch];
+	bool symmetrical = useSymmetry && board.IsSymmetrical();
+
+	uint64_t numWins = 0;
+	auto moveItr = MoveIterator(board.GetValidMoveMask());
+	while (BoardMask move = moveItr.GetNext()) {
+		uint64_t multiplicity = 1;
+		if (symmetrical) {
+			int x = Util::BitMaskToIndex(move) / 8;
+			int mirrorX = BOARD_SIZE_X - x - 1;
+			if (x > mirrorX)
+				continue;
+
+			if (x < mirrorX)
+				multiplicity = 2;
+		}
+
+		if (winMask & move) {
+			numWins += multiplicity; // Move wins the game
+			continue;
+		}
+
+		BoardState nextBoard = board;
+		nextBoard.FillMove(move);
+		fnChild(nextBoard, multiplicity);
+	}
+
+	return numWins;
+}
+
+static uint64_t CountRecursive(Perft::HashTable* hashTable, const BoardState& board, int depth, bool useSymmetry) {
+	if (depth <= 1) {
+		// Bulk count, every valid move is a leaf
+		return Util::BitCount64(board.GetValidMoveMask());
+	}
+
+	bool useHash = depth >= MIN_HASH_DEPTH;
+	uint64_t key = 0;
+	if (useHash) {
+		key = useSymmetry ? board.GetCanonicalKey() : board.GetKey();
+
+		uint64_t count;
+		if (hashTable->Find(key, depth, count))
+			return count;
+	}
+
+	uint64_t childCount = 0;
+	uint64_t count = ForEachMove(board, useSymmetry,
+		[&](const BoardState& nextBoard, uint64_t multiplicity) {
+			childCount += multiplicity * CountRecursive(hashTable, nextBoard, depth - 1, useSymmetry);
+		}
+	);
+	count += childCount;
+
+	if (useHash)
+		hashTable->Store(key, depth, count);
+
+	return count;
+}
+
+struct PerftTask {
+	BoardState board;
+	uint64_t multiplicity;
+};
+
+// Collects the positions splitPly plies below the board (transpositions merged), returns the leaves found on the way
+static uint64_t CollectTasks(
+	const BoardState& board, int splitPly, uint64_t multiplicity, bool useSymmetry,
+	std::unordered_map<uint64_t, PerftTask>& tasks) {
+
+	if (splitPly == 0) {
+		uint64_t key = useSymmetry ? board.GetCanonicalKey() : board.GetKey();
+		auto itr = tasks.find(key);
+		if (itr != tasks.end()) {
+			itr->second.multiplicity += multiplicity;
+		} else {
+			tasks[key] = PerftTask{ board, multiplicity };
+		}
+		return 0;
+	}
+
+	uint64_t numWins = ForEachMove(board, useSymmetry,
+		[&](const BoardState& nextBoard, uint64_t childMultiplicity) {
+			CollectTasks(nextBoard, splitPly - 1, multiplicity * childMultiplicity, useSymmetry, tasks);
+		}
+	);
+	return numWins * multiplicity;
+}
+
+uint64_t Perft::Count(const BoardState& board, int depth, const Config& config) {
+	if (depth <= 0)
+		return 1;
+
+	HashTable hashTable = HashTable(config.hashSizeLog2);
+
+	int splitPly = MIN(depth - 1, SPLIT_PLY);
+	std::unordered_map<uint64_t, PerftTask> taskMap;
+	uint64_t total = CollectTasks(board, splitPly, 1, config.useSymmetry, taskMap);
+
+	std::vector<PerftTask> tasks;
+	for (auto& pair : taskMap)
+		tasks.push_back(pair.second);
+
+	std::atomic<size_t> nextTask = 0;
+	std::atomic<uint64_t> taskTotal = 0;
+	auto fnWork = [&]() {
+		uint64_t threadTotal = 0;
+		for (size_t i = nextTask++; i < tasks.size(); i = nextTask++) {
+			uint64_t count = CountRecursive(&hashTable, tasks[i].board, depth - splitPly, config.useSymmetry);
+			threadTotal += count * tasks[i].multiplicity;
+		}
+		taskTotal += threadTotal;
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < config.numThreads; i++)
+		threads.push_back(std::thread(fnWork));
+	fnWork();
+	for (auto& thread : threads)
+		thread.join();
+
+	return total + taskTotal;
+}
+
+bool Perft::Run(int maxDepth, const Config& config) {
+	LOG("Running perft to depth " << maxDepth << " (threads: " << config.numThreads << ", symmetry: " << (config.useSymmetry ? "on" : "off") << ")...");
+
+	bool success = true;
+	for (int depth = 1; depth <= maxDepth; depth++) {
+		Timer timer = {};
+		uint64_t count = Count(BoardState(), depth, config);
+		double time = timer.Elapsed();
+
+		std::stringstream checkStream;
+		if (depth <= NUM_REFERENCE_COUNTS) {
+			uint64_t expected = REFERENCE_COUNTS[depth - 1];
+			if (count == expected) {
+				checkStream << "ok";
+			} else {
+				checkStream << "MISMATCH, expected " << expected;
+				success = false;
+			}
+		} else {
+			checkStream << "no reference";
+		}
+
+		LOG(" > Depth " << depth << ": " << count << " (" << checkStream.str() << "), time: " << time << "s, leaves/sec: " << Util::NumToStr(count / MAX(time, 1e-9)));
+	}
+
+	return success;
+}
\ No newline at end of file
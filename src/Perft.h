@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Search.h"
+
+// Parallel, hashed perft (leaf node counting), used to check and benchmark move generation
+// Counts the same leaves as Search::PerfTest: a winning move is a leaf, regardless of the remaining depth
+namespace Perft {
+	constexpr int DEFAULT_HASH_SIZE_LOG2 = 22;
+
+	// Leaf counts from the empty board, index is depth - 1
+	// Up to 11 these match the unhashed Search::PerfTest, above that counting with and without symmetry agree
+	constexpr uint64_t REFERENCE_COUNTS[] = {
+		7ull, 49ull, 343ull, 2401ull, 16807ull,
+		117649ull, 823536ull, 5686266ull, 39452034ull, 269175990ull,
+		1849996230ull, 12490984398ull, 84878033130ull, 565687399690ull, 3783684738326ull
+	};
+	constexpr int NUM_REFERENCE_COUNTS = sizeof(REFERENCE_COUNTS) / sizeof(REFERENCE_COUNTS[0]);
+
+	struct Config {
+		int numThreads = 1;
+		int hashSizeLog2 = DEFAULT_HASH_SIZE_LOG2;
+
+		// Only expand one side of symmetrical positions and share hash entries between mirror images
+		bool useSymmetry = false;
+	};
+
+	// Transposed subtrees are only counted once (lockless, shared by all threads)
+	struct HashTable {
+		struct Entry {
+			uint64_t check; // (key | depth << KEY_BITS) ^ count, so torn entries don't match
+			uint64_t count;
+		};
+
+		constexpr static int KEY_BITS = 56;
+
+		Entry* entries;
+		size_t size;
+
+		HashTable(int sizeLog2 = DEFAULT_HASH_SIZE_LOG2);
+		~HashTable();
+
+		HashTable(const HashTable& other) = delete;
+		HashTable& operator=(const HashTable& other) = delete;
+
+		bool Find(uint64_t key, int depth, uint64_t& outCount) const;
+		void Store(uint64_t key, int depth, uint64_t count);
+	};
+
+	uint64_t Count(const BoardState& board, int depth, const Config& config);
+
+	// Counts depths 1 to maxDepth from the empty board, logging throughput and checking against REFERENCE_COUNTS
+	// Returns false on any mismatch
+	bool Run(int maxDepth, const Config& config);
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "Ponder.h"
+
+Ponderer::Ponderer(
+	TranspositionTable* table, const BoardState& board, const Tablebase* tablebase, const Book* book, const SearchConfig& config)
+	: table(table), board(board), tablebase(tablebase), book(book), config(config) {
+	thread = std::thread(&Ponderer::Run, this);
+}
+
+Ponderer::~Ponderer() {
+	Stop();
+}
+
+void Ponderer::Stop() {
+	stopping = true;
+	if (thread.joinable())
+		thread.join();
+}
+
+bool Ponderer::Finish(int moveIndex) {
+	Stop();
+	return solved[moveIndex];
+}
+
+int Ponderer::GetNumSolved() const {
+	int numSolved = 0;
+	for (int i = 0; i < BOARD_SIZE_X; i++)
+		numSolved += solved[i];
+	return numSolved;
+}
+
+void Ponderer::Run() {
+	// Our last search usually left the reply it expects in the table
+	BoardMask tableBestMove = 0;
+	uint64_t hash = TranspositionTable::HashBoard(board);
+	TranspositionTable::Entry entry = *table->Find(hash);
+	if (entry.Matches(hash))
+		tableBestMove = entry.bestMove;
+
+	BoardMask moves[BOARD_SIZE_X];
+	int numMoves = Search::GetOrderedMoves(board, board.GetValidMoveMask(), tableBestMove, moves, NULL, config.moveWeights);
+
+	auto fnStopCheck = [this]() -> bool {
+		return stopping.load(std::memory_order_relaxed);
+	};
+
+	for (int i = 0; i < numMoves && !stopping; i++) {
+		// Replies that end the game leave us nothing to search
+		if (moves[i] & board.winMasks[board.turnSwitch])
+			continue;
+
+		BoardState nextBoard = board;
+		nextBoard.FillMove(moves[i]);
+		if (!nextBoard.GetValidMoveMask())
+			continue;
+
+		SearchResult result = Search::Search(table, nextBoard, false, tablebase, book, fnStopCheck, config);
+		totalSearched += result.totalSearched;
+		if (result.stopped)
+			break;
+
+		solved[Util::BitMaskToIndex(moves[i]) / 8] = true;
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Search.h"
+
+// Solves the opponent's replies on a background thread while they think, so our search after their move is answered by the table
+// Replies are solved one at a time in search order (the table's predicted reply first), as the likeliest ones are worth the most
+struct Ponderer {
+	Ponderer(
+		TranspositionTable* table, const BoardState& board, const Tablebase* tablebase = NULL, const Book* book = NULL,
+		const SearchConfig& config = DEFAULT_SEARCH_CONFIG
+	);
+	~Ponderer();
+
+	// Stops pondering (within STOP_POLL_INTERVAL nodes), returns whether the opponent's move was solved in time
+	bool Finish(int moveIndex);
+
+	uint64_t GetTotalSearched() const {
+		return totalSearched;
+	}
+
+	int GetNumSolved() const;
+
+private:
+	TranspositionTable* table;
+	BoardState board;
+	const Tablebase* tablebase;
+	const Book* book;
+	SearchConfig config;
+
+	std::atomic<bool> stopping = false;
+	std::thread thread;
+
+	// Only written by the thread, only read once it has been joined
+	bool solved[BOARD_SIZE_X] = {};
+	uint64_t totalSearched = 0;
+
+	void Run();
+	void Stop();
+};
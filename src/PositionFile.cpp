@@ -0,0 +1,254 @@
+#include "PositionFile.h"
+
+uint64_t PackedPosition::Pack(const BoardState& board, bool canonical) {
+	uint64_t key = board.GetKey();
+	uint64_t packed = (uint64_t)board.moveCount << PLY_SHIFT;
+
+	if (canonical) {
+		uint64_t mirroredKey = board.GetMirroredKey();
+		if (mirroredKey < key)
+			return packed | mirroredKey | MIRRORED_BIT;
+	}
+
+	return packed | key;
+}
+
+bool PackedPosition::Unpack(uint64_t packed, BoardState& outBoard) {
+	if (packed & RESERVED_BIT)
+		return false;
+
+	uint64_t key = packed & KEY_MASK;
+	if (packed & MIRRORED_BIT)
+		key = BoardMask(key).FlipX();
+
+	return BoardState::FromKey(key, outBoard) && outBoard.moveCount == GetPly(packed);
+}
+
+bool PackedPosition::IsValid(uint64_t packed) {
+	constexpr uint64_t VALID_KEY_BITS = BoardMask::GetBoardMask() | (BoardMask::GetBoardMask() << 1) | BoardMask::GetBottomMask();
+
+	uint64_t key = packed & KEY_MASK;
+	if ((packed & RESERVED_BIT) || (key & ~VALID_KEY_BITS))
+		return false;
+
+	// Every column has a bit above its top piece, so their heights sum to the ply
+	int ply = 0;
+	for (int x = 0; x < BOARD_SIZE_X; x++) {
+		uint8_t column = (uint8_t)(key >> (x * 8));
+		if (column == 0)
+			return false;
+
+		ply += std::bit_width(column) - 1;
+	}
+
+	return ply == GetPly(packed);
+}
+
+size_t PackedPosition::FindInvalid(const uint64_t* packed, size_t count) {
+	for (size_t i = 0; i < count; i++)
+		if (!IsValid(packed[i]))
+			return i;
+
+	return count;
+}
+
+bool PackedPosition::FromMoveString(const std::string& moves, uint64_t& outPacked, bool canonical) {
+	BoardState board = {};
+	for (char c : moves) {
+		if (isspace(c))
+			continue;
+
+		int x = c - '1';
+		if (x < 0 || x >= BOARD_SIZE_X || !board.IsMoveValid(x))
+			return false;
+
+		board.DoMove(x);
+	}
+
+	outPacked = Pack(board, canonical);
+	return true;
+}
+
+bool PackedPosition::ToMoveString(uint64_t packed, std::string& outMoves) {
+	BoardState board;
+	if (!Unpack(packed, board))
+		return false;
+
+	std::vector<int> moves = ReconstructMoves(board);
+	if (moves.empty() && board.moveCount > 0)
+		return false;
+
+	outMoves.clear();
+	for (int slotNum : moves)
+		outMoves += '0' + slotNum;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+PositionFile::Writer::Writer(const std::filesystem::path& path) : stream(path) {
+	isOpen = (bool)stream.stream;
+	if (!isOpen) {
+		WARN("Failed to create position file \"" << path.string() << "\"");
+		return;
+	}
+
+	// Rewritten with the final count on close
+	FileHeader header = {};
+	memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+	header.version = FILE_VERSION;
+	header.boardSizeX = BOARD_SIZE_X;
+	header.boardSizeY = BOARD_SIZE_Y;
+	stream.Write(header);
+
+	block.reserve(BLOCK_SIZE);
+}
+
+PositionFile::Writer::~Writer() {
+	Close();
+}
+
+void PositionFile::Writer::Flush() {
+	stream.WriteRaw(block.data(), block.size() * sizeof(uint64_t));
+	count += block.size();
+	block.clear();
+}
+
+bool PositionFile::Writer::Close() {
+	if (!isOpen)
+		return false;
+
+	Flush();
+
+	FileHeader header = {};
+	memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+	header.version = FILE_VERSION;
+	header.boardSizeX = BOARD_SIZE_X;
+	header.boardSizeY = BOARD_SIZE_Y;
+	header.count = count;
+
+	stream.stream.seekp(0);
+	stream.Write(header);
+	stream.stream.close();
+
+	isOpen = false;
+	return !stream.stream.fail();
+}
+
+PositionFile::Reader::Reader(const std::filesystem::path& path) : stream(path), path(path) {
+	if (!stream.stream) {
+		WARN("Failed to open position file \"" << path.string() << "\"");
+		failed = true;
+		return;
+	}
+
+	bool headerMatches =
+		stream.Read(header) &&
+		!memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) &&
+		header.version == FILE_VERSION &&
+		header.boardSizeX == BOARD_SIZE_X && header.boardSizeY == BOARD_SIZE_Y;
+
+	if (!headerMatches) {
+		WARN("Rejected position file \"" << path.string() << "\" (bad header)");
+		failed = true;
+		return;
+	}
+
+	isOpen = true;
+}
+
+bool PositionFile::Reader::ReadBlock(std::vector<uint64_t>& outBlock) {
+	if (!isOpen || failed)
+		return false;
+
+	size_t numPositions = MIN(header.count - numRead, (uint64_t)BLOCK_SIZE);
+	outBlock.resize(numPositions);
+	if (numPositions == 0)
+		return false;
+
+	size_t bytesRead = stream.ReadRaw(outBlock.data(), numPositions * sizeof(uint64_t));
+	if (bytesRead != numPositions * sizeof(uint64_t)) {
+		WARN("Position file \"" << path.string() << "\" is truncated (" << (numRead + bytesRead / sizeof(uint64_t)) << "/" << header.count << " positions)");
+		failed = true;
+		return false;
+	}
+
+	size_t invalidIndex = PackedPosition::FindInvalid(outBlock.data(), numPositions);
+	if (invalidIndex != numPositions) {
+		WARN("Position file \"" << path.string() << "\" has an invalid position at index " << (numRead + invalidIndex));
+		failed = true;
+		return false;
+	}
+
+	numRead += numPositions;
+	return true;
+}
+
+bool PositionFile::ReadBoards(const std::filesystem::path& path, std::vector<BoardState>& outBoards, size_t maxCount) {
+	Reader reader = Reader(path);
+	std::vector<uint64_t> block;
+	while (outBoards.size() < maxCount && reader.ReadBlock(block)) {
+		for (size_t i = 0; i < block.size() && outBoards.size() < maxCount; i++) {
+			BoardState board;
+			PackedPosition::Unpack(block[i], board);
+			outBoards.push_back(board);
+		}
+	}
+	return reader.IsOpen() && !reader.failed;
+}
+
+bool PositionFile::Convert(const std::filesystem::path& inPath, const std::filesystem::path& outPath) {
+	char magic[sizeof(FILE_MAGIC)] = {};
+	std::ifstream(inPath, std::ios::binary).read(magic, sizeof(magic));
+
+	if (!memcmp(magic, FILE_MAGIC, sizeof(magic))) {
+		// Positions to move strings
+		Reader reader = Reader(inPath);
+		std::ofstream outStream = std::ofstream(outPath);
+
+		uint64_t numUnreachable = 0;
+		std::vector<uint64_t> block;
+		std::string moves;
+		while (reader.ReadBlock(block)) {
+			for (uint64_t packed : block) {
+				if (PackedPosition::ToMoveString(packed, moves)) {
+					outStream << moves << '\n';
+				} else {
+					numUnreachable++;
+				}
+			}
+		}
+
+		if (numUnreachable)
+			WARN("Skipped " << numUnreachable << " positions without reconstructable moves");
+
+		LOG("Converted " << reader.numRead << " positions to move strings");
+		return !reader.failed && (bool)outStream;
+	} else {
+		// Move strings to positions
+		std::ifstream inStream = std::ifstream(inPath);
+		if (!inStream) {
+			WARN("Failed to open \"" << inPath.string() << "\"");
+			return false;
+		}
+
+		Writer writer = Writer(outPath);
+		uint64_t numWritten = 0;
+		std::string line;
+		for (int lineNum = 1; std::getline(inStream, line); lineNum++) {
+			if (line.empty())
+				continue;
+
+			uint64_t packed;
+			if (!PackedPosition::FromMoveString(line, packed)) {
+				WARN("Bad move string on line " << lineNum << ": \"" << line << "\"");
+				return false;
+			}
+			writer.Write(packed);
+			numWritten++;
+		}
+
+		LOG("Converted " << numWritten << " move strings to positions");
+		return writer.Close();
+	}
+}
\ No newline at end of file
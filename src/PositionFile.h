@@ -0,0 +1,111 @@
+#pragma once
+
+#include "BoardState.h"
+#include "DataStream.h"
+
+// Compact binary position encoding, 8 bytes per position
+//	Bits 0-55	BoardState::GetKey() (turn player's pieces plus a bit above each column's top piece)
+//	Bits 56-61	Ply (move count), redundant with the key but lets files be validated and sorted cheaply
+//	Bit 62		Mirrored, the key is of the position's mirror image
+//	Bit 63		Reserved, always 0
+namespace PackedPosition {
+	constexpr int PLY_SHIFT = 56;
+	constexpr uint64_t KEY_MASK = (1ull << PLY_SHIFT) - 1;
+	constexpr uint64_t PLY_MASK = 0x3Full << PLY_SHIFT;
+	constexpr uint64_t MIRRORED_BIT = 1ull << 62;
+	constexpr uint64_t RESERVED_BIT = 1ull << 63;
+
+	// If canonical, the smaller of the key and the mirrored key is stored (mirror images pack the same)
+	uint64_t Pack(const BoardState& board, bool canonical = false);
+
+	// Returns the position in its original orientation, false if the data is invalid
+	bool Unpack(uint64_t packed, BoardState& outBoard);
+
+	constexpr int GetPly(uint64_t packed) {
+		return (int)((packed & PLY_MASK) >> PLY_SHIFT);
+	}
+
+	// Checks the encoding, not whether the position can be reached in a game
+	bool IsValid(uint64_t packed);
+
+	// Returns the index of the first invalid position, or count if they're all valid
+	size_t FindInvalid(const uint64_t* packed, size_t count);
+
+	// Returns false if the moves aren't valid, unlike BoardState::PlayMoveString
+	bool FromMoveString(const std::string& moves, uint64_t& outPacked, bool canonical = false);
+
+	// Finds moves that reach the position, returns false if none were found
+	bool ToMoveString(uint64_t packed, std::string& outMoves);
+}
+
+// Files of packed positions, streamed in blocks
+namespace PositionFile {
+	constexpr char FILE_MAGIC[8] = "C4POS";
+	constexpr uint32_t FILE_VERSION = 1;
+
+	constexpr size_t BLOCK_SIZE = 1 << 16; // Positions per block
+
+	struct FileHeader {
+		char magic[8];
+		uint32_t version;
+		uint8_t boardSizeX, boardSizeY, pad[2];
+		uint64_t count; // Number of positions that follow
+	};
+
+	struct Writer {
+		Writer(const std::filesystem::path& path);
+		~Writer();
+
+		bool IsOpen() const {
+			return isOpen;
+		}
+
+		void Write(uint64_t packed) {
+			block.push_back(packed);
+			if (block.size() >= BLOCK_SIZE)
+				Flush();
+		}
+
+		void Write(const BoardState& board, bool canonical = false) {
+			Write(PackedPosition::Pack(board, canonical));
+		}
+
+		// Writes the remaining positions and the final count, returns false if anything failed to write
+		bool Close();
+
+	private:
+		DataStream stream;
+		std::vector<uint64_t> block;
+		uint64_t count = 0;
+		bool isOpen = false;
+
+		void Flush();
+	};
+
+	struct Reader {
+		FileHeader header = {};
+		uint64_t numRead = 0;
+		bool failed = false; // Set if the file was rejected, truncated or held an invalid position
+
+		Reader(const std::filesystem::path& path);
+
+		bool IsOpen() const {
+			return isOpen;
+		}
+
+		// Reads and validates up to BLOCK_SIZE positions, returns false at the end of the file or on failure
+		bool ReadBlock(std::vector<uint64_t>& outBlock);
+
+	private:
+		DataReadStream stream;
+		std::filesystem::path path;
+		bool isOpen = false;
+	};
+
+	// Reads up to maxCount positions in their original orientation, returns false if the file couldn't be fully read
+	bool ReadBoards(const std::filesystem::path& path, std::vector<BoardState>& outBoards, size_t maxCount = SIZE_MAX);
+
+	// Converts a position file to a text file of move strings (one per line), or the other way around
+	// The direction is picked by whether the input starts with FILE_MAGIC
+	bool Convert(const std::filesystem::path& inPath, const std::filesystem::path& outPath);
+}
\ No newline at end of file
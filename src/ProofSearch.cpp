@@ -0,0 +1,275 @@
+#include "ProofSearch.h"
+
+using namespace ProofSearch;
+
+constexpr Numbers NUMBERS_PROVEN = { 0, INFINITE };
+constexpr Numbers NUMBERS_DISPROVEN = { INFINITE, 0 };
+
+// Sums stay below infinite unless one of them is infinite
+static uint32_t AddNumbers(uint32_t a, uint32_t b) {
+	if (a == INFINITE || b == INFINITE)
+		return INFINITE;
+
+	return (uint32_t)MIN((uint64_t)a + b, (uint64_t)INFINITE - 1);
+}
+
+// The goal is part of the key, so proofs of both goals share the table
+static uint64_t MakeKey(const BoardState& board, bool drawIsSuccess) {
+	return board.GetCanonicalKey() | ((uint64_t)drawIsSuccess << 63);
+}
+
+Table::Table(size_t memoryMBs) {
+	size_t maxBuckets = MAX(memoryMBs * 1024 * 1024 / (sizeof(Entry) * BUCKET_SIZE), (size_t)1);
+	numBuckets = std::bit_floor(maxBuckets);
+	entries = std::vector<Entry>(numBuckets * BUCKET_SIZE);
+}
+
+bool Table::Find(uint64_t key, Numbers& outNumbers) const {
+	const Entry* bucket = GetBucket(key);
+	for (int i = 0; i < BUCKET_SIZE; i++) {
+		if (bucket[i].key == key) {
+			outNumbers = bucket[i].numbers;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void Table::Store(uint64_t key, Numbers numbers, uint64_t work) {
+	Entry* bucket = GetBucket(key);
+
+	Entry* target = NULL;
+	for (int i = 0; i < BUCKET_SIZE; i++) {
+		if (bucket[i].key == key) {
+			bucket[i].numbers = numbers;
+			bucket[i].work += work;
+			return;
+		}
+
+		// Prefer an empty slot, otherwise the least worked entry
+		if (!target || (target->key && (!bucket[i].key || bucket[i].work < target->work)))
+			target = &bucket[i];
+	}
+
+	if (!target->key)
+		numStored++;
+	*target = { key, numbers, work };
+
+	if (numStored >= GetCapacity() * GC_TRIGGER_FRAC)
+		CollectGarbage();
+}
+
+void Table::Reset() {
+	std::fill(entries.begin(), entries.end(), Entry{});
+	numStored = 0;
+}
+
+void Table::CollectGarbage() {
+	// Remove the smallest subtrees first, they are the cheapest to search again
+	size_t targetStored = GetCapacity() * GC_TARGET_FRAC;
+	for (uint64_t maxWork = 1; numStored > targetStored; maxWork *= 2) {
+		for (Entry& entry : entries) {
+			if (entry.key && entry.work <= maxWork) {
+				entry = {};
+				numStored--;
+				numCollected++;
+			}
+		}
+	}
+
+	numGarbageCollections++;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+struct Prover {
+	Table* table;
+	uint64_t maxNodes;
+	uint64_t nodes = 0;
+	bool stopped = false;
+
+	// Returns true if the node is decided without searching it
+	// Otherwise gives its initial numbers: one move must reach the goal, but all of them must fail to disprove it
+	// Moves are written in search order if outMoves is set
+	static bool EvalNode(const BoardState& board, bool drawIsSuccess, Numbers& outNumbers, BoardMask* outMoves, int& outNumMoves) {
+		BoardMask validMoves = board.GetValidMoveMask();
+		if (!validMoves) {
+			outNumbers = drawIsSuccess ? NUMBERS_PROVEN : NUMBERS_DISPROVEN;
+			return true;
+		}
+
+		if (validMoves & board.winMasks[board.turnSwitch]) {
+			outNumbers = NUMBERS_PROVEN;
+			return true;
+		}
+
+		Value eval = Eval::EvalAndCropValidMoves(board, validMoves);
+		if (eval != VALUE_INVALID) {
+			bool success = (eval.val > 0) || (eval.val == 0 && drawIsSuccess);
+			outNumbers = success ? NUMBERS_PROVEN : NUMBERS_DISPROVEN;
+			return true;
+		}
+
+		outNumMoves = outMoves ? Search::GetOrderedMoves(board, validMoves, 0, outMoves) : (int)Util::BitCount64(validMoves);
+		outNumbers = { 1, (uint32_t)outNumMoves };
+		return false;
+	}
+
+	// Multiple iterative deepening: searches until the node's numbers reach either threshold
+	Numbers SearchNode(BoardState& board, bool drawIsSuccess, uint32_t thresholdPhi, uint32_t thresholdDelta) {
+		nodes++;
+		if (maxNodes && nodes >= maxNodes)
+			stopped = true;
+
+		uint64_t key = MakeKey(board, drawIsSuccess);
+
+		Numbers numbers;
+		BoardMask moves[BOARD_SIZE_X];
+		int numMoves = 0;
+		if (EvalNode(board, drawIsSuccess, numbers, moves, numMoves)) {
+			table->Store(key, numbers, 1);
+			return numbers;
+		}
+
+		// Children's keys, and their numbers in case they aren't in the table
+		uint64_t childKeys[BOARD_SIZE_X];
+		Numbers childInitNumbers[BOARD_SIZE_X];
+		BoardMask selfWinMask = board.winMasks[board.turnSwitch];
+		for (int i = 0; i < numMoves; i++) {
+			board.FillMove(moves[i]);
+			childKeys[i] = MakeKey(board, !drawIsSuccess);
+
+			int childNumMoves;
+			if (EvalNode(board, !drawIsSuccess, childInitNumbers[i], NULL, childNumMoves))
+				table->Store(childKeys[i], childInitNumbers[i], 1);
+			board.UndoMove(selfWinMask);
+		}
+
+		uint64_t nodesBefore = nodes;
+		while (true) {
+			// Our proof is the easiest disproof of a child, our disproof is proving every child
+			numbers = { INFINITE, 0 };
+			int bestChild = 0;
+			Numbers bestChildNumbers = {};
+			uint32_t secondBestDelta = INFINITE;
+			for (int i = 0; i < numMoves; i++) {
+				Numbers childNumbers;
+				if (!table->Find(childKeys[i], childNumbers))
+					childNumbers = childInitNumbers[i];
+
+				numbers.delta = AddNumbers(numbers.delta, childNumbers.phi);
+				if (childNumbers.delta < numbers.phi) {
+					secondBestDelta = numbers.phi;
+					numbers.phi = childNumbers.delta;
+					bestChild = i;
+					bestChildNumbers = childNumbers;
+				} else if (childNumbers.delta < secondBestDelta) {
+					secondBestDelta = childNumbers.delta;
+				}
+			}
+
+			if (numbers.phi >= thresholdPhi || numbers.delta >= thresholdDelta || stopped)
+				break;
+
+			// The child's phi adds to our delta, its delta is our phi (until it passes the second best child)
+			uint64_t childThresholdPhi = (uint64_t)thresholdDelta - numbers.delta + bestChildNumbers.phi;
+			uint64_t childThresholdDelta = MIN((uint64_t)thresholdPhi, (uint64_t)secondBestDelta + 1);
+
+			// (Falls back on the returned numbers if the table already lost them)
+			board.FillMove(moves[bestChild]);
+			childInitNumbers[bestChild] = SearchNode(
+				board, !drawIsSuccess,
+				(uint32_t)MIN(childThresholdPhi, (uint64_t)INFINITE), (uint32_t)MIN(childThresholdDelta, (uint64_t)INFINITE)
+			);
+			board.UndoMove(selfWinMask);
+		}
+
+		table->Store(key, numbers, nodes - nodesBefore + 1);
+		return numbers;
+	}
+
+	Outcome ProveNode(const BoardState& board, bool drawIsSuccess) {
+		BoardState searchBoard = board;
+		Numbers numbers = SearchNode(searchBoard, drawIsSuccess, INFINITE, INFINITE);
+		if (numbers.phi == 0)
+			return OUTCOME_PROVEN;
+		if (numbers.delta == 0)
+			return OUTCOME_DISPROVEN;
+		return OUTCOME_UNKNOWN;
+	}
+};
+
+Result ProofSearch::Prove(Table* table, const BoardState& board, Goal goal, const Config& config) {
+	Prover prover = { table, config.maxNodes };
+	Result result = {};
+	result.outcome = prover.ProveNode(board, goal == GOAL_AT_LEAST_DRAW);
+	result.nodes = prover.nodes;
+	return result;
+}
+
+SearchResult ProofSearch::Solve(Table* table, const BoardState& board, const Config& config, bool log) {
+	Timer timer = {};
+	RASSERT(board.GetValidMoveMask(), "No valid moves in the position");
+
+	Prover prover = { table, config.maxNodes };
+
+	// Whether we win, then whether we at least draw
+	bool drawIsSuccess = false;
+	Outcome outcome = prover.ProveNode(board, drawIsSuccess);
+	if (outcome == OUTCOME_DISPROVEN) {
+		drawIsSuccess = true;
+		outcome = prover.ProveNode(board, drawIsSuccess);
+	}
+
+	SearchResult result = {};
+	if (outcome == OUTCOME_UNKNOWN) {
+		result.eval = VALUE_INVALID;
+		result.totalSearched = prover.nodes;
+		if (log)
+			LOG("Proof search hit the node limit (" << Util::NumToStr(config.maxNodes) << ")");
+		return result;
+	}
+
+	result.eval = (outcome == OUTCOME_DISPROVEN) ? Value(-1) : Value(drawIsSuccess ? 0 : 1);
+
+	// A proven node has a child whose goal is disproven, any move will do otherwise
+	BoardMask moves[BOARD_SIZE_X];
+	int numMoves = Search::GetOrderedMoves(board, board.GetValidMoveMask(), 0, moves);
+	result.move = moves[0];
+	if (outcome == OUTCOME_PROVEN) {
+		BoardMask winMoves = board.GetValidMoveMask() & board.winMasks[board.turnSwitch];
+		for (int i = 0; i < numMoves && !winMoves; i++) {
+			BoardState nextBoard = board;
+			nextBoard.FillMove(moves[i]);
+
+			// (Searched again if the table lost it)
+			Numbers childNumbers;
+			bool childDisproven = table->Find(MakeKey(nextBoard, !drawIsSuccess), childNumbers) ?
+				(childNumbers.delta == 0) : (prover.ProveNode(nextBoard, !drawIsSuccess) == OUTCOME_DISPROVEN);
+
+			if (childDisproven) {
+				result.move = moves[i];
+				break;
+			}
+		}
+
+		if (winMoves)
+			result.move = MoveIterator(winMoves).GetNext();
+	}
+	result.totalSearched = prover.nodes;
+
+	if (log) {
+		double timeElapsed = timer.Elapsed();
+		LOG(
+			"Eval: " << result.eval <<
+			", proof nodes: " << Util::NumToStr(prover.nodes) <<
+			", nodes/sec: " << Util::NumToStr(prover.nodes / MAX(timeElapsed, 1e-9)) <<
+			", table fill: " << ((double)table->GetNumStored() / table->GetCapacity()) <<
+			", garbage collections: " << table->numGarbageCollections << " (" << Util::NumToStr(table->numCollected) << " entries)"
+		);
+		LOG(" > Move: " << (int)(1 + Util::BitMaskToIndex(result.move) / 8) << ", time: " << timeElapsed << "s");
+	}
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Search.h"
+
+// Depth-first proof-number search (df-pn), an alternative engine for proving or disproving a goal for the side to move
+// Grows the tree towards the most proving (or disproving) line, which finds narrow deep forced wins alpha-beta can't order for
+// Ref: Nagai, "Df-pn Algorithm for Searching AND/OR Trees and Its Applications" (2002)
+//
+// Numbers are from the perspective of each node's side to move (phi: proof of its goal, delta: disproof)
+// The goal flips between the sides: if the root needs a win, its opponent only needs a draw, and so on
+namespace ProofSearch {
+	enum Goal {
+		GOAL_WIN,
+		GOAL_AT_LEAST_DRAW
+	};
+
+	enum Outcome {
+		OUTCOME_UNKNOWN, // Hit the node limit
+		OUTCOME_PROVEN,
+		OUTCOME_DISPROVEN
+	};
+
+	constexpr uint32_t INFINITE = UINT32_MAX;
+
+	struct Numbers {
+		uint32_t phi, delta;
+	};
+
+	// Proof/disproof numbers by position and goal, bounded in size
+	// Buckets replace their least-worked entry, and once the table fills up the smallest subtrees are collected
+	struct Table {
+		constexpr static int BUCKET_SIZE = 4;
+
+		// Garbage is collected once this fraction of entries is used, until only the target fraction is left
+		constexpr static double GC_TRIGGER_FRAC = 0.9;
+		constexpr static double GC_TARGET_FRAC = 0.6;
+
+		struct Entry {
+			uint64_t key; // 0 if empty
+			Numbers numbers;
+			uint64_t work; // Nodes searched below the entry
+		};
+
+		uint64_t numGarbageCollections = 0;
+		uint64_t numCollected = 0;
+
+		Table(size_t memoryMBs);
+
+		bool Find(uint64_t key, Numbers& outNumbers) const;
+		void Store(uint64_t key, Numbers numbers, uint64_t work);
+		void Reset();
+
+		size_t GetCapacity() const {
+			return entries.size();
+		}
+
+		size_t GetNumStored() const {
+			return numStored;
+		}
+
+	private:
+		std::vector<Entry> entries;
+		size_t numBuckets; // Always a power of two
+		size_t numStored = 0;
+
+		Entry* GetBucket(uint64_t key) {
+			return &entries[(Util::FastHash(key) & (numBuckets - 1)) * BUCKET_SIZE];
+		}
+
+		const Entry* GetBucket(uint64_t key) const {
+			return &entries[(Util::FastHash(key) & (numBuckets - 1)) * BUCKET_SIZE];
+		}
+
+		void CollectGarbage();
+	};
+
+	struct Config {
+		size_t tableMBs = 256;
+		uint64_t maxNodes = 0; // 0 for no limit
+	};
+
+	struct Result {
+		Outcome outcome = OUTCOME_UNKNOWN;
+		uint64_t nodes = 0;
+	};
+
+	// Tries to prove that the side to move reaches the goal
+	Result Prove(Table* table, const BoardState& board, Goal goal, const Config& config = {});
+
+	// Exact value with a best move, from a win proof then (unless it's proven) an at-least-draw proof
+	// The eval's depth is always 0, as proofs aren't the shortest
+	// Returns VALUE_INVALID if the node limit was hit
+	SearchResult Solve(Table* table, const BoardState& board, const Config& config, bool log);
+}
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include "Search.h"
 #include "InstaSolver.h"
+#include "Tablebase.h"
+#include "Book.h"
+#include "Batch.h"
 
 uint64_t Search::PerfTest(const BoardState& board, int depth, int depthElapsed) {
 	BoardMask validMovesMask = board.GetValidMoveMask();
@@ -26,45 +29,233 @@ uint64_t Search::PerfTest(const BoardState& board, int depth, int depthElapsed)
 	}
 }
 
-Value Search::AlphaBetaSearch(
-	TranspositionTable* table, const BoardState& board,
+// Symmetrical positions are rare past the opening, so the endgame band doesn't look for them
+template <bool CHECK_SYMMETRY>
+static int GetOrderedMovesImpl(
+	const BoardState& board, BoardMask validMovesMask, BoardMask tableBestMove, BoardMask* outMoves, BoardMask* outWinMasks,
+	const Eval::MoveWeights& weights) {
+
+	struct RatedMove {
+		BoardMask move;
+		BoardMask winMask;
+		float eval;
+	};
+	RatedMove ratedMoves[BOARD_SIZE_X];
+	int numMoves = 0;
+
+	if (CHECK_SYMMETRY && board.IsSymmetrical()) {
+		// We can just only consider moves on one side
+		BoardMask sidedMask = 0;
+		for (int x = 0; x < BOARD_SIZE_X / 2 + 1; x++)
+			sidedMask |= BoardMask::GetColumnMask(x);
+
+		validMovesMask &= sidedMask;
+		if (tableBestMove && !(tableBestMove && sidedMask)) {
+			// Flip table best move to match our side
+			tableBestMove = tableBestMove.FlipX();
+		}
+	}
+
+	// Every child's win mask in one pass, used by the ratings and kept for making the moves
+	BoardMask moves[Batch::NODE_LANES] = {};
+	BoardMask winMasks[Batch::NODE_LANES];
+	auto moveItr = MoveIterator(validMovesMask);
+	while (BoardMask move = moveItr.GetNext())
+		moves[numMoves++] = move;
+	Batch::MakeChildWinMasks(board.teams[board.turnSwitch], board.teams[!board.turnSwitch], moves, numMoves, winMasks);
+
+	for (int i = 0; i < numMoves; i++) {
+		float moveRating = Eval::RateMove(board, moves[i], winMasks[i], weights);
+
+		if (tableBestMove == moves[i])
+			moveRating = FLT_MAX;
+
+		ratedMoves[i] = RatedMove{ moves[i], winMasks[i], moveRating };
+	}
+
+	// Insertion sort the moves
+	for (size_t i = 1; i < numMoves; i++) {
+		for (size_t j = i; j > 0;) {
+			RatedMove prev = ratedMoves[j - 1];
+			RatedMove cur = ratedMoves[j];
+
+			if (cur.eval > prev.eval) {
+				// Swap
+				ratedMoves[j - 1] = cur;
+				ratedMoves[j] = prev;
+				j--;
+			} else {
+				break;
+			}
+		}
+	}
+
+	for (int i = 0; i < numMoves; i++) {
+		outMoves[i] = ratedMoves[i].move;
+		if (outWinMasks)
+			outWinMasks[i] = ratedMoves[i].winMask;
+	}
+
+	return numMoves;
+}
+
+int Search::GetOrderedMoves(
+	const BoardState& board, BoardMask validMovesMask, BoardMask tableBestMove, BoardMask* outMoves, BoardMask* outWinMasks,
+	const Eval::MoveWeights& weights) {
+
+	return GetOrderedMovesImpl<true>(board, validMovesMask, tableBestMove, outMoves, outWinMasks, weights);
+}
+
+// Compile-time variants of a node, so each one only does the work it needs
+enum SearchVariant {
+	VARIANT_TABLE = 1 << 0, // Above the endgame band, probes and stores the table and checks for symmetry (without it, never does)
+	VARIANT_EXTRAS = 1 << 1, // May probe a tablebase or book, or split nodes (without it, never does)
+	VARIANT_NEAR_LEAF = 1 << 2, // With VARIANT_TABLE, uses the table's near-leaf tier instead of the main one
+
+	// Checks the table band at runtime, as the search did before it was specialized
+	VARIANT_GENERIC = VARIANT_TABLE | VARIANT_EXTRAS | VARIANT_NEAR_LEAF | (1 << 3)
+};
+
+constexpr int VARIANT_BAND_MASK = VARIANT_TABLE | VARIANT_NEAR_LEAF;
+
+// The band's variant flags: the main table, the near-leaf tier (if the table has one), or neither in the endgame
+static int GetTableBand(const TranspositionTable* table, const BoardState& board, const SearchConfig& config) {
+	int emptyCells = BOARD_CELL_COUNT - board.moveCount;
+	if (emptyCells <= config.endgameEmptyCells)
+		return 0;
+
+	if (emptyCells <= config.endgameEmptyCells + config.nearLeafEmptyCells && table->HasNearLeaf())
+		return VARIANT_TABLE | VARIANT_NEAR_LEAF;
+
+	return VARIANT_TABLE;
+}
+
+template <int VARIANT>
+static Value AlphaBetaSearchRecursive(TranspositionTable* table, BoardState& board, SearchInfo& outInfo, SearchCache cache);
+
+// Dispatches a child node to its variant, which only changes when it crosses into a deeper band
+template <int VARIANT>
+static inline Value SearchChild(TranspositionTable* table, BoardState& board, SearchInfo& outInfo, SearchCache cache) {
+	if constexpr (VARIANT == VARIANT_GENERIC || !(VARIANT & VARIANT_TABLE)) {
+		return AlphaBetaSearchRecursive<VARIANT>(table, board, outInfo, cache);
+	} else {
+		constexpr int OTHER_FLAGS = VARIANT & ~VARIANT_BAND_MASK;
+		int band = GetTableBand(table, board, *outInfo.config);
+		if (band == (VARIANT & VARIANT_BAND_MASK))
+			return AlphaBetaSearchRecursive<VARIANT>(table, board, outInfo, cache);
+		if (band == 0)
+			return AlphaBetaSearchRecursive<OTHER_FLAGS>(table, board, outInfo, cache);
+		if (band & VARIANT_NEAR_LEAF)
+			return AlphaBetaSearchRecursive<OTHER_FLAGS | VARIANT_TABLE | VARIANT_NEAR_LEAF>(table, board, outInfo, cache);
+		return AlphaBetaSearchRecursive<OTHER_FLAGS | VARIANT_TABLE>(table, board, outInfo, cache);
+	}
+}
+
+// Plays children on the board itself (make/unmake), it's back to its original state on return unless stopped
+template <int VARIANT>
+static Value AlphaBetaSearchRecursive(
+	TranspositionTable* table, BoardState& board,
 	SearchInfo& outInfo, SearchCache cache) {
 
+	constexpr bool EXTRAS = (VARIANT & VARIANT_EXTRAS);
+
 	outInfo.totalSearched++;
+	if ((outInfo.totalSearched % STOP_POLL_INTERVAL) == 0) {
+		if (outInfo.progress)
+			outInfo.progress->nodes.fetch_add(STOP_POLL_INTERVAL, std::memory_order_relaxed);
+
+		if (outInfo.stopCheck)
+			outInfo.stopped = outInfo.stopCheck();
+	}
+
+	if (outInfo.stopped)
+		return {};
+
 	BoardMask validMovesMask = board.GetValidMoveMask();
-	BoardMask hbSelf = board.teams[board.turnSwitch];
-	BoardMask hbOpp = board.teams[!board.turnSwitch];
 	BoardMask selfWinMask = board.winMasks[board.turnSwitch];
-	BoardMask oppWinMask = board.winMasks[!board.turnSwitch];
+	SEARCH_STAT(outInfo.stats.nodes[board.moveCount]++);
 
 	Value bestEval = Eval::EvalAndCropValidMoves(board, validMovesMask);
-	if (bestEval != VALUE_INVALID)
+	if (bestEval != VALUE_INVALID) {
+		SEARCH_STAT(outInfo.stats.evalResolved[board.moveCount]++);
 		return bestEval;
+	}
 
-	bool useTable = board.moveCount < (BOARD_CELL_COUNT - 8);
+	// Check the endgame tablebase
+	// (Never at the root, which needs a best move)
+	if (EXTRAS && outInfo.tablebase && cache.depthElapsed > 0 && (BOARD_CELL_COUNT - board.moveCount) <= outInfo.tablebase->GetMaxEmpty()) {
+		Value tablebaseEval;
+		if (outInfo.tablebase->Probe(board, tablebaseEval)) {
+			SEARCH_STAT(outInfo.stats.tablebaseHits[board.moveCount]++);
+			return tablebaseEval;
+		}
+	}
+
+	if (EXTRAS && outInfo.book && cache.depthElapsed > 0 && outInfo.book->CoversPly(board.moveCount)) {
+		Value bookEval;
+		if (outInfo.book->Probe(board, bookEval)) {
+			SEARCH_STAT(outInfo.stats.bookHits[board.moveCount]++);
+			return bookEval;
+		}
+	}
+
+	const SearchConfig& config = *outInfo.config;
+	int band = (VARIANT == VARIANT_GENERIC) ? GetTableBand(table, board, config) : (VARIANT & VARIANT_BAND_MASK);
+	bool useTable = (band & VARIANT_TABLE);
+	bool nearLeaf = (band & VARIANT_NEAR_LEAF);
 
 	uint64_t hash = 0;
 	TranspositionTable::Entry* entryPtr = NULL;
 	TranspositionTable::Entry entry = {};
 	if (useTable) {
 		hash = TranspositionTable::HashBoard(board);
-		entryPtr = table->Find(hash);
-		entry = *entryPtr;
-		outInfo.totalTableSeaches++;
+		if (nearLeaf) {
+			entry = table->ProbeNearLeaf(hash);
+			outInfo.totalNearLeafSearches++;
+		} else {
+			entryPtr = table->Find(hash);
+			entry = *entryPtr;
+			outInfo.totalTableSeaches++;
+		}
+		SEARCH_STAT(outInfo.stats.tableProbes[board.moveCount]++);
 	}
+	bool tableCollision = useTable && entry.IsValid() && !entry.Matches(hash);
+	SEARCH_STAT(if (tableCollision) outInfo.stats.tableCollisions[board.moveCount]++);
 
 	BoardMask tableBestMove = 0;
 
-	if (useTable && entry.hash == hash) {
+	// What the table proved about the value, starting from the range of all values
+	Value lowerBound = Value(-1), upperBound = Value(1);
+
+	if (useTable && entry.Matches(hash)) {
 		// We have a matching entropy
+		if (nearLeaf) {
+			outInfo.totalNearLeafHits++;
+		} else {
+			outInfo.totalTableHits++;
+		}
+		SEARCH_STAT(outInfo.stats.tableHits[board.moveCount]++);
 
 		tableBestMove = entry.bestMove;
 
-		if (entry.eval >= cache.max) {
-			// Exceeds maximum, prune
-			return entry.eval;
-		} else if (!entry.isCutNode) { // It's exact
-			return entry.eval;
+		if (entry.boundType != TranspositionTable::BOUND_UPPER)
+			lowerBound = entry.eval;
+		if (entry.boundType != TranspositionTable::BOUND_LOWER)
+			upperBound = entry.eval;
+
+		// (Not at the root, which has to search to find its best move)
+		if (cache.depthElapsed > 0) {
+			// The bounds meet, or the window is entirely above or below them
+			if (lowerBound >= upperBound || lowerBound >= cache.max || upperBound <= cache.min) {
+				SEARCH_STAT(outInfo.stats.tableCutoffs[board.moveCount]++);
+				return entry.eval;
+			}
+
+			// Otherwise narrow the window to them
+			if (lowerBound > cache.min)
+				cache.min = lowerBound;
+			if (upperBound < cache.max)
+				cache.max = upperBound;
 		}
 
 #if DEBUG_TRANSPOSITION_TABLE
@@ -81,7 +272,8 @@ Value Search::AlphaBetaSearch(
 	// Check insta-solve solution
 	// (We only check on at least 1 depth, otherwise the best move would fail)
 	if (cache.depthElapsed > 1) {
-		auto solveResult = InstaSolver::Solve(board);
+		auto solveResult = InstaSolver::Solve(board, config.instaSolverRules);
+		SEARCH_STAT(outInfo.stats.AddInstaSolverResult(solveResult.rule, config.instaSolverRules));
 		if (solveResult.type) {
 			bool returnSolveResult =
 				(solveResult.type == InstaSolver::LOWER_BOUND && solveResult.eval >= cache.max) ||
@@ -93,65 +285,25 @@ Value Search::AlphaBetaSearch(
 		}
 	}
 	auto nodesBefore = outInfo.totalSearched;
+	Value originalMin = cache.min;
 
-	struct RatedMove {
-		BoardMask move;
-		float eval;
-	};
-	RatedMove ratedMoves[BOARD_SIZE_X];
-	int numMoves = 0;
-
-	if (board.IsSymmetrical()) {
-		// We can just only consider moves on one side
-		BoardMask sidedMask = 0;
-		for (int x = 0; x < BOARD_SIZE_X / 2 + 1; x++)
-			sidedMask |= BoardMask::GetColumnMask(x);
-
-		validMovesMask &= sidedMask;
-		if (tableBestMove && !(tableBestMove && sidedMask)) {
-			// Flip table best move to match our side
-			tableBestMove = tableBestMove.FlipX();
-		}
-	}
-
-	auto moveItr = MoveIterator(validMovesMask);
-	while (BoardMask move = moveItr.GetNext()) {
-
-		float moveRating = Eval::RateMove(board, move);
-
-		if (tableBestMove == move)
-			moveRating = FLT_MAX;
-
-		ratedMoves[numMoves] = RatedMove{ move, moveRating };
-		numMoves++;
-	}
-
-	// Insertion sort the moves
-	for (size_t i = 1; i < numMoves; i++) {
-		for (size_t j = i; j > 0;) {
-			RatedMove prev = ratedMoves[j - 1];
-			RatedMove cur = ratedMoves[j];
-
-			if (cur.eval > prev.eval) {
-				// Swap
-				ratedMoves[j - 1] = cur;
-				ratedMoves[j] = prev;
-				j--;
-			} else {
-				break;
-			}
-		}
-	}
+	BoardMask moves[BOARD_SIZE_X], moveWinMasks[BOARD_SIZE_X];
+	int numMoves = GetOrderedMovesImpl<(VARIANT & VARIANT_TABLE) != 0>(board, validMovesMask, tableBestMove, moves, moveWinMasks, config.moveWeights);
 	
 	BoardMask bestMove = 0;
 	for (size_t i = 0; i < numMoves; i++) {
 		Value nextEval = VALUE_INVALID;
-		auto move = ratedMoves[i].move;
+		auto move = moves[i];
+
+		if (outInfo.progress && cache.depthElapsed == 0)
+			outInfo.progress->currentRootMove.store(move, std::memory_order_relaxed);
 
-		BoardState nextBoard = board;
-		nextBoard.FillMove(move);
+		board.FillMove(move, moveWinMasks[i]);
+		nextEval = SearchChild<VARIANT>(table, board, outInfo, cache.ProgressDepth());
+		if (outInfo.stopped)
+			return {};
+		board.UndoMove(selfWinMask);
 
-		nextEval = AlphaBetaSearch(table, nextBoard, outInfo, cache.ProgressDepth());
 		nextEval = -nextEval;
 		nextEval.depth++;
 
@@ -159,6 +311,8 @@ Value Search::AlphaBetaSearch(
 			bestEval = nextEval;
 			bestMove = move;
 			outInfo.totalPruned++;
+			SEARCH_STAT(outInfo.stats.cutoffs[board.moveCount]++);
+			SEARCH_STAT(if (i == 0) outInfo.stats.firstMoveCutoffs[board.moveCount]++);
 			break;
 		}
 
@@ -170,24 +324,81 @@ Value Search::AlphaBetaSearch(
 
 			bestMove = move;
 		}
+
+		bool canSplit = 
+			EXTRAS && outInfo.splitter && (i == 0) && (numMoves > 1) &&
+			(BOARD_CELL_COUNT - board.moveCount) >= outInfo.splitter->minSplitEmptyCells;
+
+		if (canSplit) {
+			// The eldest brother is done, the rest can be searched in parallel
+			outInfo.splitter->SearchMoves(table, board, moves + 1, numMoves - 1, cache, bestEval, bestMove, outInfo);
+			if (outInfo.stopped)
+				return {};
+
+			if (bestEval >= cache.max) {
+				outInfo.totalPruned++;
+				SEARCH_STAT(outInfo.stats.cutoffs[board.moveCount]++);
+			}
+			break;
+		}
 	}
 	bool hitCutoff = bestEval >= cache.max;
+	bool failedLow = bestEval <= originalMin;
 
 	if (useTable) {
-		entry.hash = hash;
+		SEARCH_STAT(if (tableCollision) outInfo.stats.tableOverwrites[board.moveCount]++);
+
+		// A bound that meets the other known bound is exact
 		entry.bestMove = bestMove;
 		entry.eval = bestEval;
-		entry.isCutNode = hitCutoff;
+		entry.boundType = TranspositionTable::BOUND_EXACT;
+		if (hitCutoff && bestEval < upperBound) {
+			entry.boundType = TranspositionTable::BOUND_LOWER;
+		} else if (failedLow && bestEval > lowerBound) {
+			entry.boundType = TranspositionTable::BOUND_UPPER;
+		}
+
+		entry.SetHash(hash);
 #if DEBUG_TRANSPOSITION_TABLE
 		entry.board = board;
 #endif
-		*entryPtr = entry;
+		if (nearLeaf) {
+			table->StoreNearLeaf(hash, entry);
+		} else {
+			*entryPtr = entry;
+		}
 	}
 	outInfo.bestMove[cache.depthElapsed] = bestMove;
 
 	return bestEval;
 }
 
+Value Search::AlphaBetaSearch(
+	TranspositionTable* table, const BoardState& board,
+	SearchInfo& outInfo, SearchCache cache) {
+
+	BoardState workingBoard = board;
+#if SEARCH_SPECIALIZED
+	int band = GetTableBand(table, board, *outInfo.config);
+	bool useExtras = outInfo.tablebase || outInfo.book || outInfo.splitter;
+	if (useExtras) {
+		if (band == (VARIANT_TABLE | VARIANT_NEAR_LEAF))
+			return AlphaBetaSearchRecursive<VARIANT_TABLE | VARIANT_NEAR_LEAF | VARIANT_EXTRAS>(table, workingBoard, outInfo, cache);
+		if (band == VARIANT_TABLE)
+			return AlphaBetaSearchRecursive<VARIANT_TABLE | VARIANT_EXTRAS>(table, workingBoard, outInfo, cache);
+		return AlphaBetaSearchRecursive<VARIANT_EXTRAS>(table, workingBoard, outInfo, cache);
+	} else {
+		if (band == (VARIANT_TABLE | VARIANT_NEAR_LEAF))
+			return AlphaBetaSearchRecursive<VARIANT_TABLE | VARIANT_NEAR_LEAF>(table, workingBoard, outInfo, cache);
+		if (band == VARIANT_TABLE)
+			return AlphaBetaSearchRecursive<VARIANT_TABLE>(table, workingBoard, outInfo, cache);
+		return AlphaBetaSearchRecursive<0>(table, workingBoard, outInfo, cache);
+	}
+#else
+	return AlphaBetaSearchRecursive<VARIANT_GENERIC>(table, workingBoard, outInfo, cache);
+#endif
+}
+
 std::vector<BoardMask> Search::FindPVFromTable(TranspositionTable* table, const BoardState& board, BoardMask firstMove) {
 	std::vector<BoardMask> result = { firstMove };
 	
@@ -196,21 +407,25 @@ std::vector<BoardMask> Search::FindPVFromTable(TranspositionTable* table, const
 
 	while (true) {
 		auto hash = TranspositionTable::HashBoard(curBoard);
-		auto entry = table->Find(hash);
-		if (hash != entry->hash)
+		auto entry = *table->Find(hash);
+		if (!entry.Matches(hash))
 			break;
 
-		if (entry->bestMove == 0)
+		if (entry.bestMove == 0)
 			break;
 
-		result.push_back(entry->bestMove);
-		curBoard.FillMove(entry->bestMove);
+		result.push_back(entry.bestMove);
+		curBoard.FillMove(entry.bestMove);
 	}
 
 	return result;
 }
 
-SearchResult Search::Search(TranspositionTable* table, const BoardState& board, bool log) {
+SearchResult Search::Search(
+	TranspositionTable* table, const BoardState& board, bool log,
+	const Tablebase* tablebase, const Book* book, std::function<bool()> stopCheck,
+	const SearchConfig& config) {
+
 	Timer timer = {};
 	BoardMask validMoves = board.GetValidMoveMask();
 
@@ -223,7 +438,6 @@ SearchResult Search::Search(TranspositionTable* table, const BoardState& board,
 		if (log)
 			LOG("[Playing winning move]");
 
-		auto moveItr = MoveIterator(winMoveMask);
 		for (int i = 0; i < BOARD_SIZE_X; i++) {
 			if (!board.IsMoveValid(i)) {
 				continue;
@@ -239,10 +453,56 @@ SearchResult Search::Search(TranspositionTable* table, const BoardState& board,
 		ERR_CLOSE("Thought we had winning move, but never found it");
 	}
 
+	// Positions outside the book's or tablebase's subtree would probe as arbitrary values
+	if (book && !book->CoversSubtree(board))
+		book = NULL;
+	if (tablebase && !tablebase->CoversSubtree(board))
+		tablebase = NULL;
+
+	BoardMask bookMove;
+	Value bookEval;
+	if (book && book->ProbeBestMove(board, bookMove, bookEval)) {
+		if (log)
+			LOG("[Playing book move] Eval: " << bookEval);
+
+		return { bookMove, bookEval };
+	}
+
 	SearchInfo searchInfo = {};
-	Value eval = AlphaBetaSearch(table, board, searchInfo);
+	SearchProgress progress = {};
+	searchInfo.progress = &progress;
+	searchInfo.tablebase = tablebase;
+	searchInfo.book = book;
+	searchInfo.stopCheck = stopCheck;
+	searchInfo.config = &config;
+
+	Value eval;
+	{
+		std::unique_ptr<ProgressReporter> progressReporter = log ? std::make_unique<ProgressReporter>(&progress, table) : NULL;
+
+		// Null-window searches, first whether we win, then whether we at least draw
+		// The second reuses the bounds the first stored in the table
+		SearchCache winCache = {};
+		winCache.min = Value(0);
+		winCache.max = Value(1);
+		eval = AlphaBetaSearch(table, board, searchInfo, winCache);
+
+		if (eval == Value(0) && !searchInfo.stopped) {
+			SearchCache drawCache = {};
+			drawCache.min = Value(-1);
+			drawCache.max = Value(0);
+			eval = AlphaBetaSearch(table, board, searchInfo, drawCache);
+		}
+	}
 	double timeElapsed = timer.Elapsed();
 
+	if (searchInfo.stopped) {
+		SearchResult result = {};
+		result.totalSearched = searchInfo.totalSearched;
+		result.stopped = true;
+		return result;
+	}
+
 	BoardMask bestMove = searchInfo.bestMove[0];
 	if (!bestMove) {
 		// Just pick the first valid move
@@ -263,10 +523,17 @@ SearchResult Search::Search(TranspositionTable* table, const BoardState& board,
 			", searched: " << Util::NumToStr(searchInfo.totalSearched) << "/" << Util::NumToStr(searchInfo.totalPruned) <<
 			", moves/sec: " << Util::NumToStr(movesPerSecond) <<
 			", tablehitfrac: " << searchInfo.GetTableHitFrac() <<
+			(table->HasNearLeaf() ? STR(", nearleafhitfrac: " << searchInfo.GetNearLeafHitFrac()) : "") <<
 			", tablefillfrac: " << table->GetFillFrac()
 		);
 		LOG(" > PV: " << pvStr);
 	}
 
-	return { bestMove, eval, searchInfo.totalSearched };
+	SearchResult result = { bestMove, eval, searchInfo.totalSearched };
+#if SEARCH_STATS
+	result.stats = searchInfo.stats;
+	if (log)
+		result.stats.Log();
+#endif
+	return result;
 }
\ No newline at end of file
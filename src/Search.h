@@ -2,24 +2,96 @@
 
 #include "BoardState.h"
 #include "Eval.h"
+#include "InstaSolver.h"
 #include "Timer.h"
 #include "TranspositionTable.h"
+#include "SearchStats.h"
 
 #include "Util.h"
 
 constexpr int MAX_DEPTH = BOARD_CELL_COUNT;
 
+// If true, nodes are searched by compile-time variants of the search (table band, optional extras) picked by a dispatcher,
+// instead of one generic function that checks everything at runtime
+#define SEARCH_SPECIALIZED 1
+
+// How many nodes are searched between checks of SearchInfo::stopCheck
+constexpr int STOP_POLL_INTERVAL = 1024;
+
+// Runtime knobs of the search, so engine variants can be compared (Match.h) and tuned without rebuilding
+struct SearchConfig {
+	Eval::MoveWeights moveWeights = {};
+	uint32_t instaSolverRules = InstaSolver::ALL_RULES;
+
+	// Positions with at most this many empty cells are searched without the table
+	int endgameEmptyCells = 8;
+
+	// Positions with up to this many empty cells more than that use the table's near-leaf tier instead, if it has one
+	int nearLeafEmptyCells = 6;
+};
+
+inline constexpr SearchConfig DEFAULT_SEARCH_CONFIG = {};
+
+struct SearchInfo;
+struct SearchCache;
+struct Tablebase;
+struct Book;
+
+// Lets a scheduler take over the younger brothers of a node (young brothers wait)
+// The eldest move is always searched by the current thread before splitting
+struct SearchSplitter {
+	// Nodes with fewer empty cells than this are never split
+	int minSplitEmptyCells = BOARD_CELL_COUNT;
+
+	virtual ~SearchSplitter() = default;
+
+	// Searches the moves in order, updating cache.min, bestEval and bestMove the same way the serial loop would
+	virtual void SearchMoves(
+		TranspositionTable* table, const BoardState& board, const BoardMask* moves, int numMoves,
+		SearchCache& cache, Value& bestEval, BoardMask& bestMove, SearchInfo& info
+	) = 0;
+};
+
 struct SearchInfo {
 	BoardMask bestMove[MAX_DEPTH] = {};
 
 	uint64_t totalSearched = 0;
 	uint64_t totalTableSeaches = 0;
 	uint64_t totalTableHits = 0;
+	uint64_t totalNearLeafSearches = 0; // Near-leaf tier, not counted in totalTableSeaches
+	uint64_t totalNearLeafHits = 0;
 	uint64_t totalPruned = 0; // Times we pruned due to beta
 
+#if SEARCH_STATS
+	SearchStats stats = {};
+#endif
+
+	// Optional, receives the node count every STOP_POLL_INTERVAL nodes and the root move being searched
+	SearchProgress* progress = NULL;
+
+	// Optional, polled every STOP_POLL_INTERVAL nodes
+	// Once it returns true, the search unwinds and its results must be discarded
+	std::function<bool()> stopCheck = {};
+	bool stopped = false;
+
+	// Optional, used to split nodes across threads
+	SearchSplitter* splitter = NULL;
+
+	// Optional, resolves positions with few enough empty cells exactly (only for searches rooted in its subtree)
+	const Tablebase* tablebase = NULL;
+
+	// Optional, resolves positions of the plies it covers (only for searches rooted in its subtree)
+	const Book* book = NULL;
+
+	const SearchConfig* config = &DEFAULT_SEARCH_CONFIG;
+
 	double GetTableHitFrac() const {
 		return (totalTableSeaches > 0) ? (double)totalTableHits / (double)totalTableSeaches : 0;
 	}
+
+	double GetNearLeafHitFrac() const {
+		return (totalNearLeafSearches > 0) ? (double)totalNearLeafHits / (double)totalNearLeafSearches : 0;
+	}
 };
 
 struct SearchCache {
@@ -40,11 +112,31 @@ struct SearchResult {
 	BoardMask move = 0;
 	Value eval;
 	uint64_t totalSearched = 0;
+
+	// The search was stopped by its stopCheck, only totalSearched is meaningful
+	bool stopped = false;
+
+#if SEARCH_STATS
+	SearchStats stats = {};
+#endif
 };
 
 namespace Search {
+	// Moves in the order they will be searched (the table's best move always goes first)
+	// outWinMasks optionally receives the turn player's win mask after each move, for FillMove()
+	int GetOrderedMoves(
+		const BoardState& board, BoardMask validMovesMask, BoardMask tableBestMove, BoardMask* outMoves, BoardMask* outWinMasks = NULL,
+		const Eval::MoveWeights& weights = Eval::DEFAULT_MOVE_WEIGHTS
+	);
+
 	uint64_t PerfTest(const BoardState& board, int depth, int depthElapsed = 0);
 	Value AlphaBetaSearch(TranspositionTable* table, const BoardState& board, SearchInfo& outInfo, SearchCache cache = {});
 	std::vector<BoardMask> FindPVFromTable(TranspositionTable* table, const BoardState& board, BoardMask firstMove);
-	SearchResult Search(TranspositionTable* table, const BoardState& board, bool log);
+	// Plays straight from the book if it covers every move
+	// stopCheck is optional, polled the same way as SearchInfo::stopCheck
+	SearchResult Search(
+		TranspositionTable* table, const BoardState& board, bool log,
+		const Tablebase* tablebase = NULL, const Book* book = NULL, std::function<bool()> stopCheck = {},
+		const SearchConfig& config = DEFAULT_SEARCH_CONFIG
+	);
 }
\ No newline at end of file
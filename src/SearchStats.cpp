@@ -0,0 +1,104 @@
+#include "SearchStats.h"
+#include "TranspositionTable.h"
+#include "Timer.h"
+
+static void WriteJSONArray(std::ostream& stream, const char* name, const uint64_t* counts, int numCounts, bool last = false) {
+	stream << "\t\"" << name << "\": [";
+	for (int i = 0; i < numCounts; i++)
+		stream << (i ? ", " : "") << counts[i];
+	stream << "]" << (last ? "" : ",") << std::endl;
+}
+
+void SearchStats::WriteJSON(std::ostream& stream) const {
+	stream << "{" << std::endl;
+	WriteJSONArray(stream, "nodes", nodes, NUM_PLIES);
+	WriteJSONArray(stream, "cutoffs", cutoffs, NUM_PLIES);
+	WriteJSONArray(stream, "firstMoveCutoffs", firstMoveCutoffs, NUM_PLIES);
+	WriteJSONArray(stream, "evalResolved", evalResolved, NUM_PLIES);
+	WriteJSONArray(stream, "tableProbes", tableProbes, NUM_PLIES);
+	WriteJSONArray(stream, "tableHits", tableHits, NUM_PLIES);
+	WriteJSONArray(stream, "tableCutoffs", tableCutoffs, NUM_PLIES);
+	WriteJSONArray(stream, "tableCollisions", tableCollisions, NUM_PLIES);
+	WriteJSONArray(stream, "tableOverwrites", tableOverwrites, NUM_PLIES);
+	WriteJSONArray(stream, "tablebaseHits", tablebaseHits, NUM_PLIES);
+	WriteJSONArray(stream, "bookHits", bookHits, NUM_PLIES);
+
+	stream << "\t\"instaSolver\": {" << std::endl;
+	for (int i = 0; i < InstaSolver::NUM_RULES; i++) {
+		stream << "\t\t\"" << InstaSolver::RULE_NAMES[i] << "\": { \"attempts\": " << instaSolverAttempts[i] << ", \"successes\": " << instaSolverSuccesses[i] << " }";
+		stream << ((i < InstaSolver::NUM_RULES - 1) ? "," : "") << std::endl;
+	}
+	stream << "\t}" << std::endl;
+	stream << "}" << std::endl;
+}
+
+bool SearchStats::WriteJSON(const std::filesystem::path& path) const {
+	std::ofstream stream = std::ofstream(path);
+	WriteJSON(stream);
+	return (bool)stream;
+}
+
+void SearchStats::Log() const {
+	uint64_t totalNodes = Sum(nodes, NUM_PLIES);
+	uint64_t totalCutoffs = Sum(cutoffs, NUM_PLIES);
+	uint64_t totalProbes = Sum(tableProbes, NUM_PLIES);
+
+	auto fnFrac = [](uint64_t count, uint64_t total) -> double {
+		return total ? (double)count / (double)total : 0;
+	};
+
+	LOG(
+		"Stats: nodes: " << Util::NumToStr(totalNodes) <<
+		", first move cutoff rate: " << fnFrac(Sum(firstMoveCutoffs, NUM_PLIES), totalCutoffs) <<
+		", eval resolved frac: " << fnFrac(Sum(evalResolved, NUM_PLIES), totalNodes) <<
+		", table hit/collision/overwrite frac: " <<
+		fnFrac(Sum(tableHits, NUM_PLIES), totalProbes) << "/" <<
+		fnFrac(Sum(tableCollisions, NUM_PLIES), totalProbes) << "/" <<
+		fnFrac(Sum(tableOverwrites, NUM_PLIES), totalProbes) <<
+		", table cutoff frac: " << fnFrac(Sum(tableCutoffs, NUM_PLIES), totalProbes) <<
+		", tablebase/book hits: " << Util::NumToStr(Sum(tablebaseHits, NUM_PLIES)) << "/" << Util::NumToStr(Sum(bookHits, NUM_PLIES))
+	);
+
+	for (int i = 0; i < InstaSolver::NUM_RULES; i++)
+		LOG(" > InstaSolver " << InstaSolver::RULE_NAMES[i] << ": " << Util::NumToStr(instaSolverSuccesses[i]) << "/" << Util::NumToStr(instaSolverAttempts[i]));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+ProgressReporter::ProgressReporter(const SearchProgress* progress, const TranspositionTable* table, double interval)
+	: progress(progress), table(table), interval(interval) {
+	thread = std::thread(&ProgressReporter::Run, this);
+}
+
+ProgressReporter::~ProgressReporter() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	stopCondition.notify_all();
+	thread.join();
+}
+
+void ProgressReporter::Run() {
+	Timer timer = {};
+	uint64_t lastNodes = 0;
+	double lastTime = 0;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!stopCondition.wait_for(lock, std::chrono::duration<double>(interval), [this] { return stopping; })) {
+		uint64_t nodes = progress->nodes.load(std::memory_order_relaxed);
+		double time = timer.Elapsed();
+		BoardMask rootMove = progress->currentRootMove.load(std::memory_order_relaxed);
+
+		LOG(
+			"[Progress] time: " << (int)time << "s" <<
+			", searched: " << Util::NumToStr(nodes) <<
+			", moves/sec: " << Util::NumToStr((nodes - lastNodes) / MAX(time - lastTime, 1e-9)) <<
+			", hashfull: " << table->GetFillFrac() <<
+			", root move: " << (rootMove ? (char)('1' + Util::BitMaskToIndex(rootMove) / 8) : '?')
+		);
+
+		lastNodes = nodes;
+		lastTime = time;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "BoardState.h"
+#include "InstaSolver.h"
+
+// Detailed search instrumentation, set to 0 to compile it out entirely
+#define SEARCH_STATS 1
+
+#if SEARCH_STATS
+#define SEARCH_STAT(s) { s; }
+#else
+#define SEARCH_STAT(s) {}
+#endif
+
+// Counters are indexed by ply (the board's move count)
+struct SearchStats {
+	constexpr static int NUM_PLIES = BOARD_CELL_COUNT + 1;
+
+	uint64_t nodes[NUM_PLIES] = {};
+	uint64_t cutoffs[NUM_PLIES] = {};
+	uint64_t firstMoveCutoffs[NUM_PLIES] = {}; // Cutoffs from the first move searched, shows move ordering quality
+	uint64_t evalResolved[NUM_PLIES] = {}; // Nodes resolved by Eval::EvalAndCropValidMoves
+
+	uint64_t tableProbes[NUM_PLIES] = {};
+	uint64_t tableHits[NUM_PLIES] = {};
+	uint64_t tableCutoffs[NUM_PLIES] = {}; // Hits whose bounds settled the node without searching it
+	uint64_t tableCollisions[NUM_PLIES] = {}; // Probed slot held a different position
+	uint64_t tableOverwrites[NUM_PLIES] = {}; // Stored over a different position
+
+	uint64_t tablebaseHits[NUM_PLIES] = {}; // Nodes resolved by the endgame tablebase
+	uint64_t bookHits[NUM_PLIES] = {}; // Nodes resolved by the opening book
+
+	uint64_t instaSolverAttempts[InstaSolver::NUM_RULES] = {};
+	uint64_t instaSolverSuccesses[InstaSolver::NUM_RULES] = {};
+
+	void Add(const SearchStats& other) {
+		for (int i = 0; i < NUM_PLIES; i++) {
+			nodes[i] += other.nodes[i];
+			cutoffs[i] += other.cutoffs[i];
+			firstMoveCutoffs[i] += other.firstMoveCutoffs[i];
+			evalResolved[i] += other.evalResolved[i];
+			tableProbes[i] += other.tableProbes[i];
+			tableHits[i] += other.tableHits[i];
+			tableCutoffs[i] += other.tableCutoffs[i];
+			tableCollisions[i] += other.tableCollisions[i];
+			tableOverwrites[i] += other.tableOverwrites[i];
+			tablebaseHits[i] += other.tablebaseHits[i];
+			bookHits[i] += other.bookHits[i];
+		}
+
+		for (int i = 0; i < InstaSolver::NUM_RULES; i++) {
+			instaSolverAttempts[i] += other.instaSolverAttempts[i];
+			instaSolverSuccesses[i] += other.instaSolverSuccesses[i];
+		}
+	}
+
+	// Rules are tried in order, so every enabled rule up to the one that succeeded was attempted
+	void AddInstaSolverResult(InstaSolver::Rule rule, uint32_t ruleMask) {
+		for (int i = 0; i < InstaSolver::NUM_RULES && i <= rule; i++)
+			if (ruleMask & (1u << i))
+				instaSolverAttempts[i]++;
+
+		if (rule != InstaSolver::NUM_RULES)
+			instaSolverSuccesses[rule]++;
+	}
+
+	static uint64_t Sum(const uint64_t* counts, int numCounts) {
+		return std::accumulate(counts, counts + numCounts, 0ull);
+	}
+
+	void WriteJSON(std::ostream& stream) const;
+	bool WriteJSON(const std::filesystem::path& path) const;
+	void Log() const;
+};
+
+// Shared between a search and its progress reporter
+struct SearchProgress {
+	std::atomic<uint64_t> nodes = 0; // Updated every STOP_POLL_INTERVAL nodes
+	std::atomic<uint64_t> currentRootMove = 0;
+};
+
+struct TranspositionTable;
+
+// Periodically logs the progress of a search from a background thread
+struct ProgressReporter {
+	constexpr static double DEFAULT_INTERVAL = 10;
+
+	ProgressReporter(const SearchProgress* progress, const TranspositionTable* table, double interval = DEFAULT_INTERVAL);
+	~ProgressReporter();
+
+private:
+	const SearchProgress* progress;
+	const TranspositionTable* table;
+	double interval;
+
+	std::mutex mutex;
+	std::condition_variable stopCondition;
+	bool stopping = false;
+	std::thread thread;
+
+	void Run();
+};
\ No newline at end of file
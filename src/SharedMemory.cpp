@@ -0,0 +1,190 @@
+#include "SharedMemory.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// POSIX names must start with a slash
+static std::string MakeSharedName(const std::string& name) {
+	return (!name.empty() && name[0] == '/') ? name : ("/" + name);
+}
+
+bool SharedMemory::IsSupported() {
+	return true;
+}
+
+static uint8_t* MapSharedFd(int fd, size_t size) {
+	void* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	return (mapping == MAP_FAILED) ? NULL : (uint8_t*)mapping;
+}
+
+bool SharedMemory::Create(const std::string& name, size_t size) {
+	Close();
+
+	int fd = shm_open(MakeSharedName(name).c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0)
+		return false;
+
+	if (ftruncate(fd, size) != 0) {
+		close(fd);
+		Unlink(name);
+		return false;
+	}
+
+	data = MapSharedFd(fd, size);
+	close(fd);
+
+	if (!data) {
+		Unlink(name);
+		return false;
+	}
+
+	this->size = size;
+	return true;
+}
+
+bool SharedMemory::Open(const std::string& name) {
+	Close();
+
+	int fd = shm_open(MakeSharedName(name).c_str(), O_RDWR, 0600);
+	if (fd < 0)
+		return false;
+
+	struct stat fdStat;
+	if (fstat(fd, &fdStat) != 0 || fdStat.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	data = MapSharedFd(fd, fdStat.st_size);
+	close(fd);
+
+	if (!data)
+		return false;
+
+	size = fdStat.st_size;
+	return true;
+}
+
+size_t SharedMemory::GetExistingSize(const std::string& name) {
+	int fd = shm_open(MakeSharedName(name).c_str(), O_RDONLY, 0600);
+	if (fd < 0)
+		return 0;
+
+	struct stat fdStat;
+	size_t result = (fstat(fd, &fdStat) == 0) ? fdStat.st_size : 0;
+	close(fd);
+	return result;
+}
+
+void SharedMemory::Close() {
+	if (data)
+		munmap(data, size);
+
+	data = NULL;
+	size = 0;
+}
+
+bool SharedMemory::Unlink(const std::string& name) {
+	return shm_unlink(MakeSharedName(name).c_str()) == 0;
+}
+
+#else
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+// Named mappings live in the session namespace, without the POSIX slash
+static std::string MakeSharedName(const std::string& name) {
+	return (!name.empty() && name[0] == '/') ? name.substr(1) : name;
+}
+
+bool SharedMemory::IsSupported() {
+	return true;
+}
+
+// Maps the whole section, its size is rounded up to whole pages
+static uint8_t* MapSharedHandle(HANDLE mappingHandle, size_t& outSize) {
+	uint8_t* data = (uint8_t*)MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	if (!data)
+		return NULL;
+
+	MEMORY_BASIC_INFORMATION info;
+	if (VirtualQuery(data, &info, sizeof(info)) == 0) {
+		UnmapViewOfFile(data);
+		return NULL;
+	}
+
+	outSize = info.RegionSize;
+	return data;
+}
+
+bool SharedMemory::Create(const std::string& name, size_t size) {
+	Close();
+
+	// Backed by the page file, which starts zeroed
+	HANDLE handle = CreateFileMappingA(
+		INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+		(DWORD)((uint64_t)size >> 32), (DWORD)size, MakeSharedName(name).c_str()
+	);
+	if (!handle)
+		return false;
+
+	if (GetLastError() == ERROR_ALREADY_EXISTS) {
+		CloseHandle(handle);
+		return false;
+	}
+
+	size_t mappedSize;
+	data = MapSharedHandle(handle, mappedSize);
+	if (!data) {
+		CloseHandle(handle);
+		return false;
+	}
+
+	mappingHandle = handle;
+	this->size = size;
+	return true;
+}
+
+bool SharedMemory::Open(const std::string& name) {
+	Close();
+
+	HANDLE handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, MakeSharedName(name).c_str());
+	if (!handle)
+		return false;
+
+	data = MapSharedHandle(handle, size);
+	if (!data) {
+		CloseHandle(handle);
+		return false;
+	}
+
+	mappingHandle = handle;
+	return true;
+}
+
+size_t SharedMemory::GetExistingSize(const std::string& name) {
+	SharedMemory segment = {};
+	return segment.Open(name) ? segment.size : 0;
+}
+
+void SharedMemory::Close() {
+	if (data)
+		UnmapViewOfFile(data);
+	if (mappingHandle)
+		CloseHandle(mappingHandle);
+
+	data = NULL;
+	size = 0;
+	mappingHandle = NULL;
+}
+
+bool SharedMemory::Unlink(const std::string&) {
+	// Windows removes the name along with the last handle to it, nothing to do
+	return true;
+}
+
+#endif
\ No newline at end of file
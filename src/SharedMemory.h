@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Framework.h"
+
+// Named shared memory segment (POSIX shm_open + mmap, or a Windows named file mapping)
+struct SharedMemory {
+	uint8_t* data = NULL;
+	size_t size = 0;
+
+	SharedMemory() = default;
+	SharedMemory(const SharedMemory& other) = delete;
+	SharedMemory& operator=(const SharedMemory& other) = delete;
+
+	SharedMemory(SharedMemory&& other) noexcept {
+		*this = std::move(other);
+	}
+
+	SharedMemory& operator=(SharedMemory&& other) noexcept {
+		if (this != &other) {
+			Close();
+			std::swap(data, other.data);
+			std::swap(size, other.size);
+#ifdef _WIN32
+			std::swap(mappingHandle, other.mappingHandle);
+#endif
+		}
+		return *this;
+	}
+
+	~SharedMemory() {
+		Close();
+	}
+
+	static bool IsSupported();
+
+	// Creates a new zero-filled segment, fails if it already exists
+	bool Create(const std::string& name, size_t size);
+
+	// Maps an existing segment at its current size
+	bool Open(const std::string& name);
+
+	// Returns the current size of an existing segment, or 0 if there is none
+	static size_t GetExistingSize(const std::string& name);
+
+	// Unmaps the segment, other processes keep using it
+	void Close();
+
+	// Removes the name, the memory is freed once every process has unmapped it
+	static bool Unlink(const std::string& name);
+
+	bool IsOpen() const {
+		return data != NULL;
+	}
+
+private:
+#ifdef _WIN32
+	void* mappingHandle = NULL;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include "Tablebase.h"
+#include "DataStream.h"
+#include "Enumerate.h"
+#include "Timer.h"
+
+// Values every position of the level from the already valued level below it
+static void ValueLevel(
+	const uint64_t* keys, size_t numKeys, const PerfectHash::Header& hash, const uint8_t* hashData,
+	std::vector<uint8_t>& values, int numThreads) {
+
+	auto fnWork = [&](int threadIndex) {
+		for (size_t i = threadIndex; i < numKeys; i += numThreads) {
+			BoardState board;
+			BoardState::FromKey(keys[i], board);
+
+			BoardMask validMoves = board.GetValidMoveMask();
+			uint8_t bestValue;
+			if (!validMoves) {
+				bestValue = Tablebase::PACKED_DRAW;
+			} else if (validMoves & board.winMasks[board.turnSwitch]) {
+				bestValue = Tablebase::PACKED_WIN;
+			} else {
+				bestValue = Tablebase::PACKED_LOSS;
+				auto moveItr = MoveIterator(validMoves);
+				while (BoardMask move = moveItr.GetNext()) {
+					BoardState nextBoard = board;
+					nextBoard.FillMove(move);
+
+					// The child's result is the opponent's
+					uint8_t childValue = values[PerfectHash::GetIndex(hash, hashData, nextBoard.GetCanonicalKey())];
+					bestValue = MAX(bestValue, (uint8_t)(Tablebase::PACKED_WIN - childValue));
+					if (bestValue == Tablebase::PACKED_WIN)
+						break;
+				}
+			}
+
+			// (Each key has its own index, so threads never write the same value)
+			values[PerfectHash::GetIndex(hash, hashData, keys[i])] = bestValue;
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < numThreads; i++)
+		threads.push_back(std::thread(fnWork, i));
+	fnWork(0);
+	for (auto& thread : threads)
+		thread.join();
+}
+
+bool Tablebase::Build(const std::filesystem::path& path, const BuildConfig& config) {
+	RASSERT(config.maxEmpty >= 0 && config.maxEmpty <= BOARD_CELL_COUNT, "Bad tablebase empty cell count: " << config.maxEmpty);
+	RASSERT(config.numThreads >= 1, "Bad thread count: " << config.numThreads);
+
+	// (Move by move, as PlayMoveString plays on past a win)
+	BoardState root = {};
+	for (char c : config.rootMoves) {
+		root.PlayMoveString(std::string(1, c));
+		if (Eval::IsWonAfterMove(root)) {
+			WARN("The game is already over at the tablebase root \"" << config.rootMoves << "\"");
+			return false;
+		}
+	}
+	int rootEmpty = BOARD_CELL_COUNT - root.moveCount;
+	int maxEmpty = MIN(config.maxEmpty, rootEmpty);
+
+	LOG("Building tablebase of positions with at most " << config.maxEmpty << " empty cells below \"" << config.rootMoves << "\"...");
+	Timer timer = {};
+
+	// Enumerate forward from the root, keeping the levels we store
+	std::vector<uint64_t> allKeys;
+	std::vector<size_t> levelStarts = std::vector<size_t>(maxEmpty + 2); // Into allKeys, the fullest level first
+	std::vector<uint64_t> keys = { root.GetCanonicalKey() };
+	for (int empty = rootEmpty; empty >= 0; empty--) {
+		if (empty <= maxEmpty) {
+			levelStarts[empty + 1] = allKeys.size();
+			allKeys.insert(allKeys.end(), keys.begin(), keys.end());
+		}
+
+		if (empty > 0)
+			keys = Enumerate::ExpandKeys(keys, config.numThreads);
+	}
+	keys = {};
+	levelStarts[0] = allKeys.size();
+	double enumerateTime = timer.Elapsed();
+
+	FileHeader header = {};
+	memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+	header.version = FILE_VERSION;
+	header.boardSizeX = BOARD_SIZE_X;
+	header.boardSizeY = BOARD_SIZE_Y;
+	header.connectWinAmount = CONNECT_WIN_AMOUNT;
+	header.maxEmpty = maxEmpty;
+	header.rootPly = root.moveCount;
+	header.rootKey = root.GetCanonicalKey();
+
+	// Header, perfect hash, then the values
+	std::vector<uint64_t> hashData = PerfectHash::Build(allKeys, sizeof(FileHeader), header.hash, config.numThreads);
+	header.valuesOffset = sizeof(FileHeader) + hashData.size() * sizeof(uint64_t);
+	hashData.insert(hashData.begin(), sizeof(FileHeader) / sizeof(uint64_t), 0);
+	double hashTime = timer.Elapsed() - enumerateTime;
+
+	// Value from the full boards up
+	std::vector<uint8_t> values = std::vector<uint8_t>(allKeys.size(), PACKED_DRAW);
+	for (int empty = 0; empty <= maxEmpty; empty++) {
+		size_t start = levelStarts[empty + 1], end = levelStarts[empty];
+		ValueLevel(allKeys.data() + start, end - start, header.hash, (const uint8_t*)hashData.data(), values, config.numThreads);
+	}
+	double valueTime = timer.Elapsed() - enumerateTime - hashTime;
+
+	std::vector<uint8_t> packedValues = std::vector<uint8_t>(((values.size() + 3) / 4 + 7) & ~7ull, 0);
+	for (size_t i = 0; i < values.size(); i++)
+		packedValues[i / 4] |= values[i] << ((i % 4) * 2);
+
+	uint64_t size = header.valuesOffset + packedValues.size();
+	{
+		DataStream stream = DataStream(path);
+		stream.Write(header);
+		stream.WriteRaw(hashData.data() + sizeof(FileHeader) / sizeof(uint64_t), header.valuesOffset - sizeof(FileHeader));
+		stream.WriteRaw(packedValues.data(), packedValues.size());
+
+		if (!stream.stream) {
+			WARN("Failed to write tablebase to \"" << path.string() << "\"");
+			return false;
+		}
+	}
+
+	LOG(
+		" > Positions: " << Util::NumToStr(allKeys.size()) <<
+		", size: " << (size / (1024.0 * 1024.0)) << "MB (" << (size * 8.0 / MAX(allKeys.size(), (size_t)1)) << " bits/position)" <<
+		", hash levels: " << header.hash.numLevels << ", fallback keys: " << header.hash.numFallbackKeys
+	);
+	LOG(" > Enumerate time: " << enumerateTime << "s, hash time: " << hashTime << "s, value time: " << valueTime << "s");
+	return true;
+}
+
+bool Tablebase::Load(const std::filesystem::path& path) {
+	MappedFile newFile = {};
+	if (!newFile.Open(path, MappedFile::READ_ONLY))
+		return false;
+
+	const FileHeader* header = (const FileHeader*)newFile.data;
+	bool headerMatches =
+		newFile.size >= sizeof(FileHeader) &&
+		!memcmp(header->magic, FILE_MAGIC, sizeof(header->magic)) &&
+		header->version == FILE_VERSION &&
+		header->boardSizeX == BOARD_SIZE_X && header->boardSizeY == BOARD_SIZE_Y &&
+		header->connectWinAmount == CONNECT_WIN_AMOUNT &&
+		header->rootPly + header->maxEmpty <= BOARD_CELL_COUNT;
+
+	BoardState root;
+	headerMatches = headerMatches && BoardState::FromKey(header->rootKey, root) && root.moveCount == (int)header->rootPly;
+
+	// Every array GetIndex() and Probe() read must lie within the file
+	headerMatches =
+		headerMatches &&
+		PerfectHash::IsValid(header->hash, newFile.size) &&
+		Util::IsRangeInSize(header->valuesOffset, (header->hash.count + 3) / 4, 1, newFile.size);
+
+	if (!headerMatches) {
+		WARN("Rejected tablebase file \"" << path.string() << "\"");
+		return false;
+	}
+
+	file = std::move(newFile);
+	return true;
+}
+
+bool Tablebase::CoversSubtree(const BoardState& board) const {
+	if (!IsLoaded())
+		return false;
+
+	BoardState root;
+	BoardState::FromKey(GetHeader().rootKey, root);
+	return Enumerate::IsInSubtree(root, board);
+}
+
+bool Tablebase::Probe(const BoardState& board, Value& outValue) const {
+	int empty = BOARD_CELL_COUNT - board.moveCount;
+	if (empty > GetMaxEmpty())
+		return false;
+
+	uint64_t index = PerfectHash::GetIndex(GetHeader().hash, file.data, board.GetCanonicalKey());
+	uint8_t packedValue = (GetData<uint8_t>(GetHeader().valuesOffset)[index / 4] >> ((index % 4) * 2)) & 3;
+	outValue = Value((int8_t)packedValue - 1, empty);
+	return true;
+}
+
+double Tablebase::MeasureProbeLatency(int numProbes) const {
+	// Random games from the root, stopped at a random covered number of empty cells
+	std::mt19937_64 rng = std::mt19937_64(0);
+	BoardState root;
+	BoardState::FromKey(GetHeader().rootKey, root);
+
+	std::vector<BoardState> boards;
+	for (int attempt = 0; boards.size() < (size_t)numProbes && attempt < numProbes * 100; attempt++) {
+		BoardState board = root;
+		int targetPly = BOARD_CELL_COUNT - rng() % (GetHeader().maxEmpty + 1);
+		while (board.moveCount < targetPly) {
+			BoardMask moves = board.GetValidMoveMask() & ~board.winMasks[board.turnSwitch];
+			if (!moves)
+				break;
+
+			int numMoves = Util::BitCount64(moves);
+			auto moveItr = MoveIterator(moves);
+			for (int i = rng() % numMoves; i > 0; i--)
+				moveItr.GetNext();
+			board.FillMove(moveItr.GetNext());
+		}
+
+		if (board.moveCount == targetPly)
+			boards.push_back(board);
+	}
+
+	if (boards.empty())
+		return 0;
+
+	Timer timer = {};
+	int64_t valueSum = 0;
+	for (const BoardState& board : boards) {
+		Value value;
+		Probe(board, value);
+		valueSum += value.val;
+	}
+	double time = timer.Elapsed();
+
+	RASSERT(std::abs(valueSum) <= (int64_t)boards.size(), "Tablebase probes failed");
+	return time * 1e9 / boards.size();
+}
\ No newline at end of file
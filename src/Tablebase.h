@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Eval.h"
+#include "MappedFile.h"
+#include "PerfectHash.h"
+
+// Exact values of every position with at most maxEmpty empty cells reachable from a root position
+// Built exhaustively: positions are enumerated forward from the root, then valued from the fullest level up
+//
+// Keys aren't stored: a minimal perfect hash (PerfectHash) maps each canonical key to a unique index in a 2-bit value array,
+// so a position that isn't in the tablebase probes as an arbitrary value
+// Only probe positions reachable from its root (with the game still going),
+// searches check CoversSubtree() on their root before using the tablebase
+struct Tablebase {
+	constexpr static char FILE_MAGIC[8] = "C4TBASE";
+	constexpr static uint32_t FILE_VERSION = 2;
+
+	// Side to move's result
+	enum PackedValue : uint8_t {
+		PACKED_LOSS, PACKED_DRAW, PACKED_WIN
+	};
+
+	struct FileHeader {
+		char magic[8];
+		uint32_t version;
+		uint8_t boardSizeX, boardSizeY, connectWinAmount, pad;
+		uint32_t maxEmpty; // At most the root's empty cells
+		uint32_t rootPly;
+		uint64_t rootKey; // Canonical key of the root
+		PerfectHash::Header hash;
+		uint64_t valuesOffset; // 4 values per byte
+	};
+
+	struct BuildConfig {
+		std::string rootMoves = {};
+		int maxEmpty = 10;
+		int numThreads = 1;
+	};
+
+	Tablebase() = default;
+	Tablebase(const Tablebase& other) = delete;
+	Tablebase& operator=(const Tablebase& other) = delete;
+
+	static bool Build(const std::filesystem::path& path, const BuildConfig& config);
+
+	// Memory-maps a built tablebase
+	bool Load(const std::filesystem::path& path);
+
+	bool IsLoaded() const {
+		return file.IsOpen();
+	}
+
+	int GetMaxEmpty() const {
+		return IsLoaded() ? (int)GetHeader().maxEmpty : -1;
+	}
+
+	// Whether the board is reachable from the tablebase's root (or its mirror image),
+	// so every position with few enough empty cells a search from it reaches is in the tablebase
+	bool CoversSubtree(const BoardState& board) const;
+
+	// Returns false if the position has too many empty cells
+	// The depth of the value is the number of empty cells, an upper bound on the remaining moves
+	bool Probe(const BoardState& board, Value& outValue) const;
+
+	// Average nanoseconds per probe of positions in the tablebase
+	double MeasureProbeLatency(int numProbes = 1'000'000) const;
+
+private:
+	MappedFile file;
+
+	const FileHeader& GetHeader() const {
+		return *(const FileHeader*)file.data;
+	}
+
+	template <typename T>
+	const T* GetData(uint64_t offset) const {
+		return (const T*)(file.data + offset);
+	}
+};
\ No newline at end of file
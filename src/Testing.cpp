@@ -1,9 +1,20 @@
 #include "Testing.h"
+#include "ParallelSearch.h"
+#include "Numa.h"
+#include "PerfCounters.h"
+#include "ProofSearch.h"
+#include "Batch.h"
+#include "Book.h"
+#include "Tablebase.h"
+#include "PositionFile.h"
+#include "C4Api.h"
 
-BoardState Testing::GeneratePosition(int numMoves) {
-	BoardState board;
-	while (true) { // Loop until we find the best move
-		board = {};
+// fnRandom returns a random non-negative integer
+template <typename T>
+static BoardState GeneratePositionImpl(int numMoves, T&& fnRandom) {
+	while (true) { // Loop until we find a position without a simple win/loss on the way
+		BoardState board = {};
+		bool foundResult = false;
 
 		for (int i = 0; i < numMoves; i++) {
 			BoardMask validMovesMask = board.GetValidMoveMask();
@@ -11,7 +22,8 @@ BoardState Testing::GeneratePosition(int numMoves) {
 
 			if (value != VALUE_INVALID) {
 				// We detected a simple win/loss, retry
-				continue;
+				foundResult = true;
+				break;
 			}
 
 			BoardMask chosenMove;
@@ -27,16 +39,42 @@ BoardState Testing::GeneratePosition(int numMoves) {
 				while (BoardMask move = moveItr.GetNext())
 					moves[numMoves++] = move;
 
-				chosenMove = moves[rand() % numMoves];
+				chosenMove = moves[fnRandom() % numMoves];
 			}
 
 			board.FillMove(chosenMove);
 		}
 
-		break;
+		if (!foundResult)
+			return board;
 	}
+}
+
+BoardState Testing::GeneratePosition(int numMoves) {
+	return GeneratePositionImpl(numMoves, rand);
+}
 
-	return board;
+BoardState Testing::GeneratePosition(int numMoves, std::mt19937_64& rng) {
+	return GeneratePositionImpl(numMoves, rng);
+}
+
+std::vector<BoardState> Testing::GenerateUniquePositions(int numMoves, size_t count, uint64_t seed) {
+	// Gives up after this many duplicates per position asked for
+	constexpr size_t MAX_DUPLICATES_PER_POSITION = 100;
+
+	std::mt19937_64 rng = std::mt19937_64(seed);
+	std::unordered_set<uint64_t> seen;
+	std::vector<BoardState> result;
+	size_t numDuplicates = 0;
+	while (result.size() < count && numDuplicates < count * MAX_DUPLICATES_PER_POSITION) {
+		BoardState board = GeneratePosition(numMoves, rng);
+		if (seen.insert(board.GetCanonicalKey()).second) {
+			result.push_back(board);
+		} else {
+			numDuplicates++;
+		}
+	}
+	return result;
 }
 
 void Testing::TestMoveEval(TranspositionTable* table, int numSamples) {
@@ -96,8 +134,13 @@ void Testing::TestEfficiency(TranspositionTable* table, int numSamples) {
 
 	constexpr int DEPTHS[] = { 16, 20, 25 };
 
+	PerfCounters counters = {};
+	if (!counters.IsAnyAvailable())
+		WARN("No hardware performance counters available (see /proc/sys/kernel/perf_event_paranoid)");
+
 	for (int depth : DEPTHS) {
 		SearchInfo searchInfo = {};
+		counters.Reset();
 
 		int movesRemaining = MAX(BOARD_CELL_COUNT - depth  - 2, 1);
 		uint64_t targetSearchCount = pow(GOOD_BRANCHING_FACTOR, movesRemaining);
@@ -106,12 +149,471 @@ void Testing::TestEfficiency(TranspositionTable* table, int numSamples) {
 			BoardState board = Testing::GeneratePosition(depth);
 
 			// Do normal search to assess eval
-			Value eval = Search::AlphaBetaSearch(table, board, searchInfo);
+			counters.Start();
+			Search::AlphaBetaSearch(table, board, searchInfo);
+			counters.Stop();
 		}
 
 		uint64_t avgSearched = searchInfo.totalSearched / numSamples;
 		double scoreFrac = (double)targetSearchCount / (double)avgSearched;
 		LOG(" > Depth " << depth << ", score: " << scoreFrac << ", avg searched: " << Util::NumToStr(avgSearched) << ", table hit frac: " << searchInfo.GetTableHitFrac());
+		if (counters.IsAnyAvailable())
+			LOG("   Per node: " << counters.ToString(searchInfo.totalSearched));
+	}
+
+	LOG(" Done in " << timer.Elapsed() << "s");
+}
+
+void Testing::TestParallelScaling(TranspositionTable* table, int maxThreads, int numSamples) {
+	LOG("Running parallel scaling test...");
+	srand(0);
+	Timer timer = {};
+
+	constexpr int DEPTH = 10;
+
+	std::vector<BoardState> boards;
+	for (int i = 0; i < numSamples; i++)
+		boards.push_back(Testing::GeneratePosition(DEPTH));
+
+	std::vector<SearchResult> firstResults;
+	double firstTime = 0;
+	for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+		Timer threadsTimer = {};
+		uint64_t totalSearched = 0;
+
+		for (int i = 0; i < numSamples; i++) {
+			table->Reset();
+			ParallelSearch::Config config = {};
+			config.numThreads = numThreads;
+			SearchResult result = ParallelSearch::Search(table, boards[i], config, false);
+			totalSearched += result.totalSearched;
+
+			if (numThreads == 1) {
+				firstResults.push_back(result);
+			} else {
+				// Results must not depend on the thread count
+				RASSERT(
+					result.eval == firstResults[i].eval && result.move == firstResults[i].move,
+					"Parallel search result differs from single-threaded result (threads: " << numThreads << ", sample: " << i << ")"
+				);
+			}
+		}
+
+		double time = threadsTimer.Elapsed();
+		if (numThreads == 1)
+			firstTime = time;
+
+		LOG(
+			" > Threads: " << numThreads << ", time: " << time << "s, speedup: " << (firstTime / time) <<
+			", searched: " << Util::NumToStr(totalSearched) << ", moves/sec: " << Util::NumToStr(totalSearched / time)
+		);
+	}
+
+	LOG(" Done in " << timer.Elapsed() << "s");
+}
+
+void Testing::TestNuma(TranspositionTable* table, int numSamples) {
+	LOG("Running NUMA test...");
+	Numa::LogTopology();
+	Timer timer = {};
+
+	constexpr int DEPTH = 12;
+
+	srand(0);
+	std::vector<BoardState> boards;
+	for (int i = 0; i < numSamples; i++)
+		boards.push_back(Testing::GeneratePosition(DEPTH));
+
+	const Numa::Topology& topology = Numa::GetTopology();
+	int maxNodes = topology.nodeCpus.size();
+	for (int numNodes : { 1, maxNodes }) {
+		for (auto placement : { Numa::PLACEMENT_DEFAULT, Numa::PLACEMENT_INTERLEAVE, Numa::PLACEMENT_PARTITION }) {
+			// Use every cpu of the nodes
+			int numThreads = 0;
+			for (int i = 0; i < numNodes; i++)
+				numThreads += topology.nodeCpus[i].size();
+			numThreads = CLAMP(numThreads, 1, ParallelSearch::MAX_THREADS);
+
+			ParallelSearch::Config config = {};
+			config.numThreads = numThreads;
+			config.pinCpus = Numa::GetPinCpus(numThreads, numNodes);
+
+			table->Reset();
+			bool placed = Numa::PlaceMemory(table->entries, table->GetSizeBytes(), placement, numNodes);
+
+			Timer searchTimer = {};
+			uint64_t totalSearched = 0;
+			for (BoardState& board : boards)
+				totalSearched += ParallelSearch::Search(table, board, config, false).totalSearched;
+			double time = searchTimer.Elapsed();
+
+			constexpr const char* PLACEMENT_NAMES[] = { "first-touch", "interleave", "partition" };
+			LOG(
+				" > Nodes: " << numNodes << ", threads: " << numThreads << ", placement: " << PLACEMENT_NAMES[placement] << (placed ? "" : " (failed)") <<
+				", time: " << time << "s, moves/sec: " << Util::NumToStr(totalSearched / time)
+			);
+		}
+
+		if (maxNodes == 1)
+			break; // Nothing else to compare
+	}
+
+	LOG(" Done in " << timer.Elapsed() << "s");
+}
+
+// 1 for a win, 0 for a draw, -1 for a loss
+static int GetValueSign(Value value) {
+	return (value.val > 0) - (value.val < 0);
+}
+
+void Testing::TestProofSearch(TranspositionTable* table, int numSamples) {
+	LOG("Running proof search test...");
+	srand(0);
+	Timer timer = {};
+
+	// Random positions are rarely drawn, so the last pass only keeps draws
+	struct Pass {
+		int depth;
+		bool drawsOnly;
+	};
+	constexpr Pass PASSES[] = { { 14, false }, { 18, false }, { 22, false }, { 26, true } };
+	constexpr int MAX_ATTEMPTS_PER_SAMPLE = 50;
+
+	ProofSearch::Config proofConfig = {};
+	ProofSearch::Table proofTable = ProofSearch::Table(proofConfig.tableMBs);
+	for (const Pass& pass : PASSES) {
+		uint64_t alphaBetaSearched = 0, proofSearched = 0;
+		double alphaBetaTime = 0, proofTime = 0;
+		int numChecked = 0, numDraws = 0;
+
+		for (int attempt = 0; numChecked < numSamples && attempt < numSamples * MAX_ATTEMPTS_PER_SAMPLE; attempt++) {
+			BoardState board = Testing::GeneratePosition(pass.depth);
+
+			table->Reset();
+			Timer searchTimer = {};
+			SearchResult result = Search::Search(table, board, false);
+			double searchTime = searchTimer.Elapsed();
+
+			int expectedSign = GetValueSign(result.eval);
+			if (pass.drawsOnly && expectedSign != 0)
+				continue;
+
+			// Wins are proven, draws need a disproven win and a proven draw, losses disprove both
+			proofTable.Reset();
+			Timer proofTimer = {};
+			SearchResult proofResult = ProofSearch::Solve(&proofTable, board, proofConfig, false);
+			double solveTime = proofTimer.Elapsed();
+
+			RASSERT(
+				proofResult.eval != VALUE_INVALID && proofResult.eval.val == expectedSign,
+				"Proof search eval " << proofResult.eval << " disagrees with alpha-beta (" << result.eval << ") on " << board
+			);
+
+			// The proof's move must be legal and keep the value
+			BoardMask move = proofResult.move;
+			RASSERT(Util::BitCount64(move) == 1 && (move & board.GetValidMoveMask()), "Proof search played an invalid move on " << board);
+
+			int moveSign;
+			if (move & board.winMasks[board.turnSwitch]) {
+				moveSign = 1;
+			} else {
+				BoardState nextBoard = board;
+				nextBoard.FillMove(move);
+				moveSign = nextBoard.GetValidMoveMask() ? -GetValueSign(Search::Search(table, nextBoard, false).eval) : 0;
+			}
+			RASSERT(moveSign == expectedSign, "Proof search move " << (1 + Util::BitMaskToIndex(move) / 8) << " loses value on " << board);
+
+			numChecked++;
+			numDraws += (expectedSign == 0);
+			alphaBetaSearched += result.totalSearched;
+			alphaBetaTime += searchTime;
+			proofSearched += proofResult.totalSearched;
+			proofTime += solveTime;
+		}
+
+		LOG(
+			" > Depth " << pass.depth << (pass.drawsOnly ? " (draws only)" : "") << ", draws: " << numDraws << "/" << numChecked <<
+			", alpha-beta: " << Util::NumToStr(alphaBetaSearched) << " nodes in " << alphaBetaTime << "s" <<
+			", proof search: " << Util::NumToStr(proofSearched) << " nodes in " << proofTime << "s"
+		);
+	}
+
+	LOG(" Done in " << timer.Elapsed() << "s");
+}
+
+void Testing::TestTablebase(TranspositionTable* table, int numSamples) {
+	LOG("Running tablebase test...");
+	srand(0);
+	Timer timer = {};
+
+	std::string rootMoves = "256737144116147433";
+	Tablebase::BuildConfig buildConfig = {};
+	buildConfig.rootMoves = rootMoves;
+	buildConfig.maxEmpty = 10;
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "c4_test.tablebase";
+	RASSERT(Tablebase::Build(path, buildConfig), "Failed to build the test tablebase");
+
+	Tablebase tablebase = {};
+	RASSERT(tablebase.Load(path), "Failed to load the test tablebase");
+
+	BoardState root = {};
+	root.PlayMoveString(rootMoves);
+
+	// Random moves that don't win, returns false if it got stuck
+	auto fnPlayRandom = [](BoardState& board, int targetPly) -> bool {
+		while (board.moveCount < targetPly) {
+			BoardMask moves = board.GetValidMoveMask() & ~board.winMasks[board.turnSwitch];
+			if (!moves)
+				return false;
+
+			auto moveItr = MoveIterator(moves);
+			for (int i = rand() % Util::BitCount64(moves); i > 0; i--)
+				moveItr.GetNext();
+			board.FillMove(moveItr.GetNext());
+		}
+		return true;
+	};
+
+	// Random games from the root down to the tablebase's levels, probed against the search
+	for (int i = 0; i < numSamples; i++) {
+		BoardState board = root;
+		if (!fnPlayRandom(board, BOARD_CELL_COUNT - rand() % (tablebase.GetMaxEmpty() + 1))) {
+			i--;
+			continue;
+		}
+
+		RASSERT(tablebase.CoversSubtree(board), "Tablebase doesn't cover a position below its root: " << board);
+
+		Value value;
+		RASSERT(tablebase.Probe(board, value), "Tablebase doesn't have a position at its levels: " << board);
+
+		int expectedValue = 0;
+		if (board.GetValidMoveMask()) {
+			table->Reset();
+			expectedValue = GetValueSign(Search::Search(table, board, false).eval);
+		}
+		RASSERT(GetValueSign(value) == expectedValue, "Tablebase disagrees with the search on " << board);
+	}
+
+	// Whole searches with the tablebase, from inside its subtree and from positions outside it
+	uint64_t nodesWith = 0, nodesWithout = 0;
+	int numInside = 0, numOutside = 0;
+	for (int i = 0; i < numSamples / 10; i++) {
+		BoardState board = (i % 2) ? Testing::GeneratePosition(root.moveCount + 2) : root;
+		if (!(i % 2) && !fnPlayRandom(board, root.moveCount + rand() % 4))
+			continue;
+
+		bool inside = tablebase.CoversSubtree(board);
+		table->Reset();
+		SearchResult without = Search::Search(table, board, false);
+		table->Reset();
+		SearchResult with = Search::Search(table, board, false, &tablebase);
+		RASSERT(
+			GetValueSign(with.eval) == GetValueSign(without.eval),
+			"Search with the tablebase disagrees on " << board << " (" << (inside ? "inside" : "outside") << " its subtree)"
+		);
+
+		if (inside) {
+			nodesWith += with.totalSearched;
+			nodesWithout += without.totalSearched;
+			numInside++;
+		} else {
+			numOutside++;
+		}
+	}
+	RASSERT(nodesWith < nodesWithout, "The tablebase was never used");
+
+	std::error_code error;
+	std::filesystem::remove(path, error);
+
+	LOG(
+		" > Probed: " << numSamples << ", searched inside/outside its subtree: " << numInside << "/" << numOutside <<
+		", nodes inside with/without it: " << Util::NumToStr(nodesWith) << "/" << Util::NumToStr(nodesWithout)
+	);
+	LOG(" Done in " << timer.Elapsed() << "s");
+}
+
+void Testing::TestApi(TranspositionTable* table, int numSamples) {
+	LOG("Running C API test...");
+	srand(0);
+	Timer timer = {};
+
+	RASSERT(c4_api_version() == C4_API_VERSION, "Bad C API version");
+
+	C4Config config;
+	c4_default_config(&config);
+	config.tableSizeMBs = 64;
+	config.numThreads = 0;
+	RASSERT(!c4_create(&config), "Created a solver without threads");
+
+	config.numThreads = 2;
+	C4Solver* solver = c4_create(&config);
+	RASSERT(solver, "Failed to create a solver");
+
+	// Bad arguments and positions
+	uint64_t position;
+	C4Result result;
+	C4Result moveResults[C4_NUM_COLUMNS];
+	RASSERT(c4_solve(NULL, 0, &result) == C4_ERROR_INVALID_ARGUMENT && c4_solve(solver, 0, NULL) == C4_ERROR_INVALID_ARGUMENT, "Accepted null arguments");
+	RASSERT(c4_encode_moves("48", &position) == C4_ERROR_INVALID_POSITION, "Encoded a move off the board");
+	RASSERT(c4_solve(solver, PackedPosition::RESERVED_BIT, &result) == C4_ERROR_INVALID_POSITION, "Solved an invalid position");
+	RASSERT(c4_encode_moves("1212121", &position) == C4_OK && c4_solve(solver, position, &result) == C4_ERROR_GAME_OVER, "Solved a won position");
+	RASSERT(
+		c4_encode_moves("256737144116147411", &position) == C4_OK && c4_analyze(solver, position, moveResults) == C4_OK &&
+		moveResults[0].status == C4_ERROR_INVALID_MOVE,
+		"Analyzed a move in a full column"
+	);
+
+	// Every call against direct searches
+	std::vector<BoardState> boards;
+	std::vector<uint64_t> positions;
+	std::vector<int> expectedValues;
+	for (int i = 0; i < numSamples; i++) {
+		BoardState board = Testing::GeneratePosition(16 + rand() % 8);
+		position = PackedPosition::Pack(board);
+
+		table->Reset();
+		int expectedValue = GetValueSign(Search::Search(table, board, false).eval);
+		RASSERT(c4_solve(solver, position, &result) == C4_OK && result.value == expectedValue, "c4_solve disagrees with the search on " << board);
+
+		RASSERT(c4_analyze(solver, position, moveResults) == C4_OK, "c4_analyze failed on " << board);
+		for (int x = 0; x < BOARD_SIZE_X; x++) {
+			if (!board.IsMoveValid(x)) {
+				RASSERT(moveResults[x].status == C4_ERROR_INVALID_MOVE, "c4_analyze valued a full column on " << board);
+				continue;
+			}
+
+			BoardMask move = board.GetValidMoveMask() & BoardMask::GetColumnMask(x);
+			BoardState nextBoard = board;
+			nextBoard.FillMove(move);
+
+			int expectedMoveValue;
+			if (move & board.winMasks[board.turnSwitch]) {
+				expectedMoveValue = 1;
+			} else {
+				expectedMoveValue = nextBoard.GetValidMoveMask() ? -GetValueSign(Search::Search(table, nextBoard, false).eval) : 0;
+			}
+			RASSERT(
+				moveResults[x].status == C4_OK && moveResults[x].value == expectedMoveValue,
+				"c4_analyze disagrees with the search on move " << (x + 1) << " of " << board
+			);
+		}
+
+		RASSERT(
+			result.bestMove >= 0 && result.bestMove < BOARD_SIZE_X && moveResults[result.bestMove].status == C4_OK &&
+			moveResults[result.bestMove].value == expectedValue,
+			"c4_solve's best move loses value on " << board
+		);
+
+		boards.push_back(board);
+		positions.push_back(position);
+		expectedValues.push_back(expectedValue);
+	}
+
+	std::vector<C4Result> batchResults = std::vector<C4Result>(positions.size());
+	RASSERT(c4_solve_batch(solver, positions.data(), positions.size(), batchResults.data()) == C4_OK, "c4_solve_batch failed");
+	for (size_t i = 0; i < positions.size(); i++)
+		RASSERT(batchResults[i].status == C4_OK && batchResults[i].value == expectedValues[i], "c4_solve_batch disagrees with the search on " << boards[i]);
+	c4_destroy(solver);
+
+	// A solver with a book must still solve positions outside the book's subtree
+	std::string rootMoves = "2567371441161474";
+	Book::BuildConfig bookConfig = {};
+	bookConfig.rootMoves = rootMoves;
+	bookConfig.maxPly = 20;
+	std::filesystem::path bookPath = std::filesystem::temp_directory_path() / "c4_api_test.book";
+	RASSERT(Book::Build(bookPath, bookConfig), "Failed to build the test book");
+
+	std::string bookPathStr = bookPath.string();
+	config.bookPath = bookPathStr.c_str();
+	solver = c4_create(&config);
+	RASSERT(solver, "Failed to create a solver with a book");
+
+	for (std::string moves : { rootMoves, rootMoves + "3", rootMoves + "377" }) {
+		BoardState board = {};
+		board.PlayMoveString(moves);
+		boards.push_back(board);
+		expectedValues.push_back(GetValueSign(Search::Search(table, board, false).eval));
+	}
+
+	int numInBook = 0;
+	for (size_t i = 0; i < boards.size(); i++) {
+		RASSERT(c4_solve(solver, PackedPosition::Pack(boards[i]), &result) == C4_OK, "c4_solve failed with a book on " << boards[i]);
+		RASSERT(result.value == expectedValues[i], "c4_solve disagrees with the search with a book on " << boards[i]);
+		numInBook += (result.nodes == 0);
+	}
+	RASSERT(numInBook > 0, "The book was never used");
+
+	c4_destroy(solver);
+	std::error_code error;
+	std::filesystem::remove(bookPath, error);
+
+	LOG(" > Positions: " << boards.size() << " (" << numInBook << " answered by the book)");
+	LOG(" Done in " << timer.Elapsed() << "s");
+}
+
+void Testing::TestBatchKernels(int numBoards) {
+	LOG("Running batch kernel test (best instruction set: " << Batch::ISA_NAMES[Batch::GetBestIsa()] << ")...");
+	srand(0);
+	Timer timer = {};
+
+	// Enough passes over the boards for stable timings
+	constexpr int NUM_REPEATS = 200;
+
+	std::vector<uint64_t> selfMasks, oppMasks, combinedMasks, oppWinMasks;
+	std::vector<uint64_t> expectedWinMasks, expectedMoves, expectedCroppedMoves;
+	std::vector<Value> expectedValues;
+	for (int i = 0; i < numBoards; i++) {
+		BoardState board = Testing::GeneratePosition(rand() % (BOARD_CELL_COUNT - 8));
+		selfMasks.push_back(board.teams[board.turnSwitch]);
+		oppMasks.push_back(board.teams[!board.turnSwitch]);
+		combinedMasks.push_back(board.GetCombinedMask());
+		oppWinMasks.push_back(board.winMasks[!board.turnSwitch]);
+
+		expectedWinMasks.push_back(board.teams[board.turnSwitch].MakeWinMask());
+		expectedMoves.push_back(board.GetValidMoveMask());
+
+		BoardMask croppedMoves = board.GetValidMoveMask();
+		expectedValues.push_back(Eval::EvalAndCropValidMoves(board, croppedMoves));
+		expectedCroppedMoves.push_back(croppedMoves);
+	}
+
+	std::vector<uint64_t> winMasks(numBoards), moves(numBoards), croppedMoves(numBoards);
+	std::vector<Value> values(numBoards);
+	for (int isaIndex = 0; isaIndex < Batch::ISA_COUNT; isaIndex++) {
+		auto isa = (Batch::Isa)isaIndex;
+		if (!Batch::IsSupported(isa)) {
+			LOG(" > " << Batch::ISA_NAMES[isa] << ": not supported");
+			continue;
+		}
+
+		auto fnTime = [&](auto fnKernel) {
+			Timer kernelTimer = {};
+			for (int i = 0; i < NUM_REPEATS; i++)
+				fnKernel();
+			return Util::NumToStr((double)numBoards * NUM_REPEATS / MAX(kernelTimer.Elapsed(), 1e-9));
+		};
+
+		std::string winMaskRate = fnTime([&] { Batch::MakeWinMasks(selfMasks.data(), winMasks.data(), numBoards, isa); });
+		std::string movesRate = fnTime([&] { Batch::GetValidMoveMasks(combinedMasks.data(), moves.data(), numBoards, isa); });
+		std::string cropRate = fnTime([&] {
+			Batch::EvalAndCropValidMoves(selfMasks.data(), oppMasks.data(), oppWinMasks.data(), croppedMoves.data(), values.data(), numBoards, isa);
+		});
+
+		for (int i = 0; i < numBoards; i++) {
+			RASSERT(winMasks[i] == expectedWinMasks[i], "Batched win mask differs (" << Batch::ISA_NAMES[isa] << ", board " << i << ")");
+			RASSERT(moves[i] == expectedMoves[i], "Batched valid moves differ (" << Batch::ISA_NAMES[isa] << ", board " << i << ")");
+			RASSERT(
+				values[i].val == expectedValues[i].val && values[i].depth == expectedValues[i].depth &&
+				(values[i] != VALUE_INVALID || croppedMoves[i] == expectedCroppedMoves[i]),
+				"Batched eval differs (" << Batch::ISA_NAMES[isa] << ", board " << i << ")"
+			);
+		}
+
+		LOG(
+			" > " << Batch::ISA_NAMES[isa] << ", boards/sec: win masks: " << winMaskRate <<
+			", valid moves: " << movesRate << ", eval and crop: " << cropRate
+		);
 	}
 
 	LOG(" Done in " << timer.Elapsed() << "s");
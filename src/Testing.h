@@ -3,8 +3,19 @@
 #include "Search.h"
 
 namespace Testing {
+	// Random position after numMoves moves, none of which led to a simple win/loss
 	BoardState GeneratePosition(int numMoves);
+	BoardState GeneratePosition(int numMoves, std::mt19937_64& rng); // Thread-safe with a per-thread rng
+
+	// Up to count of them, unique modulo mirror images (fewer if the ply runs out of positions)
+	std::vector<BoardState> GenerateUniquePositions(int numMoves, size_t count, uint64_t seed);
 
 	void TestMoveEval(TranspositionTable* table, int numSamples = 50);
 	void TestEfficiency(TranspositionTable* table, int numSamples = 50);
+	void TestParallelScaling(TranspositionTable* table, int maxThreads = 64, int numSamples = 10);
+	void TestNuma(TranspositionTable* table, int numSamples = 10);
+	void TestProofSearch(TranspositionTable* table, int numSamples = 10);
+	void TestTablebase(TranspositionTable* table, int numSamples = 1000);
+	void TestApi(TranspositionTable* table, int numSamples = 20);
+	void TestBatchKernels(int numBoards = 1 << 16);
 }
\ No newline at end of file
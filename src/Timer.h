@@ -10,12 +10,12 @@ struct Timer {
 
 	// Returns elapsed time in seconds
 	double Elapsed() {
-		auto endTime = std::chrono::high_resolution_clock::now();
+		auto endTime = std::chrono::steady_clock::now();
 		std::chrono::duration<double> elapsed = endTime - startTime;
 		return elapsed.count();
 	}
 
 	void Reset() {
-		startTime = std::chrono::high_resolution_clock::now();
+		startTime = std::chrono::steady_clock::now();
 	}
 };
\ No newline at end of file
@@ -1 +1,184 @@
 #include "TranspositionTable.h"
+#include "DataStream.h"
+#include "Timer.h"
+
+TranspositionTable::FileHeader TranspositionTable::MakeFileHeader(size_t size) {
+	FileHeader header = {};
+	memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+	header.version = FILE_VERSION;
+	header.entryFormat = ENTRY_FORMAT;
+	header.entrySize = sizeof(Entry);
+	header.boardSizeX = BOARD_SIZE_X;
+	header.boardSizeY = BOARD_SIZE_Y;
+	header.connectWinAmount = CONNECT_WIN_AMOUNT;
+	header.size = size;
+
+	BoardState hashCheckBoard = {};
+	hashCheckBoard.PlayMoveString("4453");
+	header.hashCheck = HashBoard(hashCheckBoard);
+
+	header.dataOffset = FILE_DATA_ALIGNMENT;
+	static_assert(sizeof(FileHeader) <= FILE_DATA_ALIGNMENT);
+	return header;
+}
+
+const char* TranspositionTable::FindHeaderMismatch(const FileHeader& header, size_t dataSize) {
+	FileHeader expectedHeader = MakeFileHeader(header.size);
+
+	if (memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) != 0) {
+		return "not a table file";
+	} else if (header.version != FILE_VERSION) {
+		return "file version";
+	} else if (header.entryFormat != ENTRY_FORMAT || header.entrySize != sizeof(Entry)) {
+		return "entry format";
+	} else if (header.boardSizeX != BOARD_SIZE_X || header.boardSizeY != BOARD_SIZE_Y || header.connectWinAmount != CONNECT_WIN_AMOUNT) {
+		return "board geometry";
+	} else if (header.hashCheck != expectedHeader.hashCheck) {
+		return "hash function";
+	} else if (header.size == 0 || !std::has_single_bit(header.size)) {
+		return "table size";
+	} else if (header.dataOffset != expectedHeader.dataOffset || dataSize < header.dataOffset) {
+		return "file size";
+	} else if (header.size > (dataSize - header.dataOffset) / sizeof(Entry) || dataSize != header.dataOffset + header.size * sizeof(Entry)) {
+		// (Size checked before multiplying, so a huge size can't wrap around to a match)
+		return "file size";
+	}
+
+	return NULL;
+}
+
+void TranspositionTable::FreeEntries() {
+	if (mappedFile.IsOpen()) {
+		mappedFile.Close();
+	} else if (sharedMemory.IsOpen()) {
+		sharedMemory.Close();
+	} else {
+		free(entries);
+	}
+	entries = NULL;
+}
+
+bool TranspositionTable::Save(const std::filesystem::path& path) const {
+	FileHeader header = MakeFileHeader(size);
+
+	// Write to a temporary file first so a crash never leaves a broken table behind
+	std::filesystem::path tempPath = path;
+	tempPath += ".tmp";
+	{
+		DataStream stream = DataStream(tempPath);
+		stream.Write(header);
+
+		std::vector<uint8_t> padding = std::vector<uint8_t>(header.dataOffset - sizeof(header), 0);
+		stream.WriteRaw(padding.data(), padding.size());
+		stream.WriteRaw(entries, GetSizeBytes());
+
+		if (!stream.stream) {
+			WARN("Failed to write table to \"" << tempPath.string() << "\"");
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+	return !error;
+}
+
+bool TranspositionTable::Load(const std::filesystem::path& path) {
+	MappedFile file = {};
+	if (!file.Open(path, MappedFile::COPY_ON_WRITE))
+		return false;
+
+	if (file.size < sizeof(FileHeader)) {
+		WARN("Table file \"" << path.string() << "\" is too small");
+		return false;
+	}
+
+	FileHeader header;
+	memcpy(&header, file.data, sizeof(header));
+
+	const char* mismatch = FindHeaderMismatch(header, file.size);
+	if (mismatch) {
+		WARN("Rejected table file \"" << path.string() << "\" (mismatched " << mismatch << ")");
+		return false;
+	}
+
+	FreeEntries();
+	mappedFile = std::move(file);
+
+	entries = (Entry*)(mappedFile.data + header.dataOffset);
+	size = header.size;
+	return true;
+}
+
+
+bool TranspositionTable::AttachShared(const std::string& name, size_t sizeLog2) {
+	if (!SharedMemory::IsSupported()) {
+		WARN("Shared tables are not supported on this platform");
+		return false;
+	}
+
+	FileHeader newHeader = MakeFileHeader(1ull << sizeLog2);
+	size_t newTotalSize = newHeader.dataOffset + newHeader.size * sizeof(Entry);
+
+	SharedMemory segment = {};
+	for (int attempt = 0; attempt < 2; attempt++) {
+		if (segment.Create(name, newTotalSize)) {
+			// We are the creator, the memory is already zeroed
+			SharedHeader* sharedHeader = (SharedHeader*)segment.data;
+			sharedHeader->fileHeader = newHeader;
+			sharedHeader->isReady.store(1, std::memory_order_release);
+			break;
+		}
+
+		// It already exists, wait for the creator to finish
+		Timer timer = {};
+		bool ready = false;
+		while (!ready && timer.Elapsed() < SHARED_CREATE_TIMEOUT) {
+			if (SharedMemory::GetExistingSize(name) >= sizeof(SharedHeader) && segment.Open(name)) {
+				ready = ((SharedHeader*)segment.data)->isReady.load(std::memory_order_acquire);
+				if (!ready)
+					segment.Close();
+			}
+
+			if (!ready)
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+
+		if (ready)
+			break;
+
+		// The creator died before finishing, remove it and try again
+		WARN("Removing stale shared table \"" << name << "\"");
+		SharedMemory::Unlink(name);
+	}
+
+	if (!segment.IsOpen()) {
+		WARN("Failed to attach shared table \"" << name << "\"");
+		return false;
+	}
+
+	FileHeader header = ((SharedHeader*)segment.data)->fileHeader;
+	const char* mismatch = FindHeaderMismatch(header, segment.size);
+	if (mismatch) {
+		WARN("Rejected shared table \"" << name << "\" (mismatched " << mismatch << ")");
+		return false;
+	}
+
+	if (header.size != newHeader.size)
+		WARN("Using existing shared table size of " << (header.size * sizeof(Entry) / 1'000'000) << "MB");
+
+	FreeEntries();
+	sharedMemory = std::move(segment);
+	entries = (Entry*)(sharedMemory.data + header.dataOffset);
+	size = header.size;
+	return true;
+}
+
+void TranspositionTable::DetachShared() {
+	if (!IsShared())
+		return;
+
+	FreeEntries();
+	entries = (Entry*)calloc(size, sizeof(Entry));
+	RASSERT(entries, "Failed to allocate transposition table");
+}
\ No newline at end of file
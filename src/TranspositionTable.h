@@ -1,21 +1,44 @@
 #pragma once
 #include "BoardState.h"
 #include "Eval.h"
+#include "MappedFile.h"
+#include "SharedMemory.h"
 
 #define DEBUG_TRANSPOSITION_TABLE 0
 #define PRINT_HASHES 0
 
 struct TranspositionTable {
+	// What an entry's eval tells us about the position's true value
+	enum BoundType : uint8_t {
+		BOUND_EXACT,
+		BOUND_LOWER, // The search failed high, the value is at least eval
+		BOUND_UPPER // The search failed low, the value is at most eval
+	};
+
 	struct Entry {
+		// Stored XOR'd with the entry's data (see SetHash()), so entries torn by concurrent writers won't match
 		uint64_t hash;
-		BoardMask bestMove;
+		BoardMask bestMove; // Best move found, even when failing low (used for move ordering)
 		Value eval;
-		bool isCutNode;
+		BoundType boundType;
 
 #if DEBUG_TRANSPOSITION_TABLE
 		BoardState board;
 #endif
 
+		uint64_t GetDataKey() const {
+			return bestMove ^ ((uint64_t)(uint8_t)eval.val << 56) ^ ((uint64_t)eval.depth << 48) ^ boundType;
+		}
+
+		// Must be called after the data is set
+		void SetHash(uint64_t boardHash) {
+			hash = boardHash ^ GetDataKey();
+		}
+
+		bool Matches(uint64_t boardHash) const {
+			return (hash ^ GetDataKey()) == boardHash;
+		}
+
 		bool IsValid() const {
 			return hash != NULL;
 		}
@@ -25,15 +48,72 @@ struct TranspositionTable {
 		}
 	};
 
-	constexpr static size_t SIZE = 1 << 25 /* Power of two for maximum "%" speed */;
-	constexpr static size_t SIZE_MBS = (sizeof(Entry) * SIZE) / 1'000'000;
+	constexpr static size_t DEFAULT_SIZE_LOG2 = 25 /* Power of two for maximum "%" speed */;
+	constexpr static size_t DEFAULT_SIZE = 1ull << DEFAULT_SIZE_LOG2;
+	constexpr static size_t DEFAULT_SIZE_MBS = (sizeof(Entry) * DEFAULT_SIZE) / 1'000'000;
+
+	// Saved table files
+	constexpr static char FILE_MAGIC[8] = "C4TABLE";
+	constexpr static uint32_t FILE_VERSION = 1;
+	constexpr static uint32_t ENTRY_FORMAT = 2; // Must be bumped whenever Entry's layout or meaning changes
+	constexpr static size_t FILE_DATA_ALIGNMENT = 4096; // Entries start on their own page
+
+	struct FileHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t entryFormat;
+		uint32_t entrySize;
+		uint8_t boardSizeX, boardSizeY, connectWinAmount, pad;
+		uint64_t size;
+		uint64_t hashCheck; // Hash of a fixed position, changes if the hash function does
+		uint64_t dataOffset;
+	};
+
+	// Start of a shared table segment, entries follow at FileHeader::dataOffset
+	struct SharedHeader {
+		FileHeader fileHeader;
+		std::atomic<uint32_t> isReady; // Set by the creator once the header is written
+	};
+
+	// How long to wait for another process to finish creating a shared table before assuming it crashed
+	constexpr static double SHARED_CREATE_TIMEOUT = 5;
+
+	// Buckets of the optional near-leaf tier, 32k of them (1.5MB) fit in a 2MB L2 cache
+	constexpr static size_t DEFAULT_NEAR_LEAF_SIZE_LOG2 = 15;
+	constexpr static int NEAR_LEAF_BUCKET_SIZE = 2;
 
 	////////////////////////////////////////////////////////////////////////
 
-	Entry entries[SIZE];
+	Entry* entries;
+	size_t size; // Always a power of two
+
+	// Optional second tier for the positions just above the endgame band (see SearchConfig::nearLeafEmptyCells),
+	// small enough to stay in cache, and keeping those frequent but cheap positions from evicting the main table's entries
+	// Never saved or shared, each process (and each table) has its own
+	std::vector<Entry> nearLeafEntries;
+	size_t nearLeafSize = 0; // Buckets, always a power of two (0 if there's no tier)
+
+	// Entries are mapped from a file when loaded, or from shared memory when attached, otherwise they are owned
+	MappedFile mappedFile;
+	SharedMemory sharedMemory;
+
+	TranspositionTable(size_t sizeLog2 = DEFAULT_SIZE_LOG2) {
+		size = 1ull << sizeLog2;
+
+		// Large calloc()s get lazily zeroed pages from the OS, so this is instant
+		entries = (Entry*)calloc(size, sizeof(Entry));
+		RASSERT(entries, "Failed to allocate " << (GetSizeBytes() / 1'000'000) << "MB transposition table");
+	}
+
+	TranspositionTable(const TranspositionTable& other) = delete;
+	TranspositionTable& operator=(const TranspositionTable& other) = delete;
 
-	TranspositionTable() {
-		Reset();
+	~TranspositionTable() {
+		FreeEntries();
+	}
+
+	size_t GetSizeBytes() const {
+		return size * sizeof(Entry);
 	}
 
 	static uint64_t HashBoard(const BoardState& board) {
@@ -48,11 +128,41 @@ struct TranspositionTable {
 	}
 
 	void Reset() {
-		memset(entries, 0, sizeof(entries));
+		memset(entries, 0, GetSizeBytes());
+		std::fill(nearLeafEntries.begin(), nearLeafEntries.end(), Entry{});
+	}
+
+	void EnableNearLeaf(size_t sizeLog2 = DEFAULT_NEAR_LEAF_SIZE_LOG2) {
+		nearLeafSize = 1ull << sizeLog2;
+		nearLeafEntries.assign(nearLeafSize * NEAR_LEAF_BUCKET_SIZE, Entry{});
+	}
+
+	bool HasNearLeaf() const {
+		return nearLeafSize > 0;
+	}
+
+	// Returns the bucket's matching entry, otherwise its first one (which doesn't match)
+	Entry ProbeNearLeaf(uint64_t hash) const {
+		const Entry* bucket = &nearLeafEntries[(hash & (nearLeafSize - 1)) * NEAR_LEAF_BUCKET_SIZE];
+		return bucket[1].Matches(hash) ? bucket[1] : bucket[0];
+	}
+
+	// The first slot keeps the entry proven over the most moves (eval.depth), the second always takes the newest,
+	// including whatever the first slot gives up
+	void StoreNearLeaf(uint64_t hash, const Entry& entry) {
+		Entry* bucket = &nearLeafEntries[(hash & (nearLeafSize - 1)) * NEAR_LEAF_BUCKET_SIZE];
+		bool firstMatches = bucket[0].Matches(hash);
+		if (firstMatches || entry.eval.depth >= bucket[0].eval.depth) {
+			if (!firstMatches)
+				bucket[1] = bucket[0]; // (Also drops a stale copy of this position from the second slot)
+			bucket[0] = entry;
+		} else {
+			bucket[1] = entry;
+		}
 	}
 
 	size_t LoopIndex(size_t index) {
-		return index % SIZE;
+		return index & (size - 1);
 	}
 
 	Entry* Get(size_t index) {
@@ -69,10 +179,36 @@ struct TranspositionTable {
 	}
 
 	double GetFillFrac() const {
-		constexpr size_t MAX_SAMPLES = MIN(100'000, SIZE);
+		size_t MAX_SAMPLES = MIN(100'000, size);
 		size_t numFilled = 0;
 		for (size_t i = 0; i < MAX_SAMPLES; i++)
 			numFilled += entries[i].IsValid();
 		return (double)numFilled / (double)MAX_SAMPLES;
 	}
+
+	// Writes the table to a versioned binary file
+	// Returns false on failure
+	bool Save(const std::filesystem::path& path) const;
+
+	// Maps a saved table (copy-on-write, so the file is never modified)
+	// Returns false and leaves the table untouched if the file is missing or doesn't match this build
+	bool Load(const std::filesystem::path& path);
+
+	// Uses (or creates) a table in a named shared memory segment, shared by all processes on the host that attach to it
+	// Entries are updated lock-free, so processes crashing mid-write can't corrupt the table
+	// If the segment already exists, its size is used instead of sizeLog2
+	// Returns false and leaves the table untouched on failure
+	bool AttachShared(const std::string& name, size_t sizeLog2 = DEFAULT_SIZE_LOG2);
+
+	// Goes back to a private, empty table of the same size
+	void DetachShared();
+
+	bool IsShared() const {
+		return sharedMemory.IsOpen();
+	}
+
+private:
+	static FileHeader MakeFileHeader(size_t size);
+	static const char* FindHeaderMismatch(const FileHeader& header, size_t dataSize);
+	void FreeEntries();
 };
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "Tune.h"
+#include "PositionFile.h"
+#include "Testing.h"
+
+uint64_t Tune::EvaluateWeights(const std::vector<BoardState>& corpus, const Eval::MoveWeights& weights, int numThreads, int tableSizeLog2) {
+	SearchConfig searchConfig = {};
+	searchConfig.moveWeights = weights;
+
+	std::atomic<size_t> nextIndex = 0;
+	std::atomic<uint64_t> totalNodes = 0;
+	auto fnWork = [&]() {
+		TranspositionTable table = TranspositionTable(tableSizeLog2);
+		for (size_t i = nextIndex++; i < corpus.size(); i = nextIndex++) {
+			table.Reset();
+			SearchResult result = Search::Search(&table, corpus[i], false, NULL, NULL, {}, searchConfig);
+			totalNodes += result.totalSearched;
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < numThreads; i++)
+		threads.push_back(std::thread(fnWork));
+	fnWork();
+	for (auto& thread : threads)
+		thread.join();
+
+	return totalNodes;
+}
+
+std::string Tune::FormatWeights(const Eval::MoveWeights& weights) {
+	std::stringstream stream;
+	stream << "constexpr MoveWeights DEFAULT_MOVE_WEIGHTS = {" << std::endl;
+	for (auto& field : Eval::MOVE_WEIGHT_FIELDS)
+		stream << "\t." << field.memberName << " = " << (weights.*field.member) << "," << std::endl;
+	stream << "};";
+	return stream.str();
+}
+
+static std::string DescribeWeights(const Eval::MoveWeights& weights) {
+	std::stringstream stream;
+	for (int i = 0; i < Eval::NUM_MOVE_WEIGHTS; i++) {
+		auto& field = Eval::MOVE_WEIGHT_FIELDS[i];
+		stream << (i ? "," : "") << field.name << "=" << (weights.*field.member);
+	}
+	return stream.str();
+}
+
+Eval::MoveWeights Tune::Run(const Config& config) {
+	RASSERT(config.numThreads >= 1, "Bad thread count: " << config.numThreads);
+	RASSERT(config.startStep > 0 && config.minStep > 0, "Bad tuning steps: " << config.startStep << ", " << config.minStep);
+
+	std::vector<BoardState> corpus;
+	if (config.corpusPath.empty()) {
+		corpus = Testing::GenerateUniquePositions(config.corpusPly, config.corpusSize, config.seed);
+	} else {
+		PositionFile::ReadBoards(config.corpusPath, corpus);
+
+		// Only positions left to search
+		std::erase_if(corpus, [](const BoardState& board) {
+			return !board.GetValidMoveMask() || Eval::IsWonAfterMove(board);
+		});
+	}
+
+	if (corpus.empty()) {
+		WARN("No corpus positions to tune on");
+		return config.startWeights;
+	}
+
+	Timer timer = {};
+	Eval::MoveWeights bestWeights = config.startWeights;
+	uint64_t startNodes = EvaluateWeights(corpus, bestWeights, config.numThreads, config.tableSizeLog2);
+	uint64_t bestNodes = startNodes;
+	LOG("Tuning move weights on " << corpus.size() << " positions, starting at " << Util::NumToStr(startNodes) << " nodes (" << timer.Elapsed() << "s per evaluation)...");
+
+	float step = config.startStep;
+	for (int round = 0; round < config.maxRounds && step >= config.minStep; round++) {
+		bool improved = false;
+
+		for (auto& field : Eval::MOVE_WEIGHT_FIELDS) {
+			// Try both directions, then keep going the way that helped
+			for (float direction : { 1.f, -1.f }) {
+				while (true) {
+					Eval::MoveWeights weights = bestWeights;
+					float& weight = weights.*field.member;
+					weight += direction * step * MAX(fabsf(weight), 1.f);
+
+					uint64_t nodes = EvaluateWeights(corpus, weights, config.numThreads, config.tableSizeLog2);
+					if (nodes >= bestNodes)
+						break;
+
+					LOG(" > " << field.name << " = " << weight << ": " << Util::NumToStr(nodes) << " nodes (" << (100.0 * nodes / startNodes) << "%)");
+					bestWeights = weights;
+					bestNodes = nodes;
+					improved = true;
+				}
+			}
+		}
+
+		LOG(" > Round " << (round + 1) << " done, step: " << step << ", nodes: " << Util::NumToStr(bestNodes) << " (" << (100.0 * bestNodes / startNodes) << "%), time: " << timer.Elapsed() << "s");
+		if (!improved)
+			step /= 2;
+	}
+
+	LOG("Tuned weights (" << Util::NumToStr(startNodes) << " -> " << Util::NumToStr(bestNodes) << " nodes): " << DescribeWeights(bestWeights));
+	LOG(FormatWeights(bestWeights));
+	return bestWeights;
+}
\ No newline at end of file
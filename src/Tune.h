@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Search.h"
+
+// Tunes the move ordering weights (Eval::MoveWeights) to minimize the nodes searched to solve a fixed corpus of positions
+// Coordinate descent: each weight in turn is scaled up and down by a step while that lowers the total, the step shrinks once no weight moves
+// Every corpus evaluation is spread across threads, and is deterministic (a fresh table per position)
+namespace Tune {
+	struct Config {
+		// Optional position file, otherwise corpusSize random unique positions at corpusPly
+		std::string corpusPath = {};
+		int corpusPly = 14;
+		int corpusSize = 200;
+		uint64_t seed = 0;
+
+		int numThreads = 1;
+		int tableSizeLog2 = 20;
+
+		Eval::MoveWeights startWeights = Eval::DEFAULT_MOVE_WEIGHTS;
+
+		// Weights move by a fraction of their magnitude (at least 1)
+		float startStep = 0.5f;
+		float minStep = 0.05f;
+		int maxRounds = 20;
+	};
+
+	// Total nodes to solve every position of the corpus with the weights
+	uint64_t EvaluateWeights(const std::vector<BoardState>& corpus, const Eval::MoveWeights& weights, int numThreads, int tableSizeLog2);
+
+	// The weights as a DEFAULT_MOVE_WEIGHTS definition, to be compiled back into Eval.h
+	std::string FormatWeights(const Eval::MoveWeights& weights);
+
+	// Returns the best weights found (the start weights if the corpus couldn't be loaded)
+	Eval::MoveWeights Run(const Config& config);
+}
\ No newline at end of file
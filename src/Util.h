@@ -55,4 +55,9 @@ namespace Util {
 	constexpr uint8_t GetByteFirstBit(uint8_t val) {
 		return val & -(int8_t)val;
 	}
+
+	// Whether count elements of elemSize bytes at offset fit in size bytes, without overflowing
+	constexpr bool IsRangeInSize(uint64_t offset, uint64_t count, uint64_t elemSize, uint64_t size) {
+		return offset <= size && count <= (size - offset) / elemSize;
+	}
 }
\ No newline at end of file